@@ -0,0 +1,277 @@
+/*
+ * Copyright 2024 Toni500git
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ * disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _ARCHIVE_HPP
+#define _ARCHIVE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "page.hpp"
+#include "util.hpp"
+
+typedef struct ZSTD_DDict_s ZSTD_DDict;
+typedef struct ZSTD_DCtx_s  ZSTD_DCtx;
+typedef struct ZSTD_CCtx_s  ZSTD_CCtx;
+typedef struct ZSTD_CDict_s ZSTD_CDict;
+
+constexpr char     ARCHIVE_MAGIC[4] = { 'W', 'R', 'P', 'A' };
+constexpr uint32_t ARCHIVE_VERSION  = 7;
+
+/* The page archive (version 7) is a single file that gets mmap()ed once and read in place:
+ *   ArchiveHeader | page blobs | zstd dictionary | ArchiveEntry[entry_count] | page index | names
+ * - blobs: the pages compiled into render tokens (see page.hpp), one per distinct content. Those flagged
+ *   ENTRY_COMPRESSED are single zstd frames using the dictionary, which is trained on the corpus at pack time.
+ *   They come first so the archive can be written in one pass while the pages are still coming in.
+ * - entries: one per "language/platform/command" ("en" being the "pages" directory), sorted by name. Every platform
+ *   has an entry for every command: the pages missing from it are resolved at pack time
+ *   (platform -> common -> other platforms) and flagged ENTRY_RESOLVED. Entries with the same content hash share
+ *   their blob, so comparing two archives only needs their entry tables.
+ * - page index: a minimal perfect hash (CHD) over the names, uint32_t displacement[bucket_count] followed by
+ *   uint32_t slot[entry_count] mapping a hash slot to its entry. A lookup is one probe and a fingerprint check.
+ * Integers are in native byte order, it's a local cache and not meant to be shared between machines.
+ */
+struct ArchiveHeader
+{
+    char     magic[4];
+    uint32_t version;
+    uint32_t entry_count;
+    uint32_t bucket_count;
+    uint64_t hash_seed;
+    uint64_t blobs_off;
+    uint64_t dict_off;
+    uint64_t dict_size;
+    uint64_t entries_off;
+    uint64_t index_off;
+    uint64_t names_off;
+    uint64_t file_size;
+};
+
+enum EntryFlags : uint16_t
+{
+    ENTRY_RESOLVED   = 1 << 0,
+    ENTRY_COMPRESSED = 1 << 1,
+};
+
+struct ArchiveEntry
+{
+    uint32_t name_off;
+    uint16_t name_len;
+    uint16_t flags;
+    uint32_t blob_len;
+    uint32_t fingerprint;  // upper half of the name hash
+    uint32_t page_len;     // length of the compiled page once decompressed
+    uint32_t reserved;
+    uint64_t blob_off;
+    uint64_t content_hash;  // hash_bytes() of the page markdown
+};
+
+class PageArchive
+{
+public:
+    PageArchive() = default;
+    ~PageArchive();
+
+    PageArchive(const PageArchive&)            = delete;
+    PageArchive& operator=(const PageArchive&) = delete;
+
+    bool open(const std::string_view path);
+    void close();
+
+    bool is_open() const
+    { return this->file.data() != nullptr; }
+
+    static constexpr size_t npos = -1;
+
+    /* Find the entry of a command in a platform
+     * @param language The language code (e.g "en", "pt_BR")
+     * @param platform The platform directory name (e.g "linux", "common")
+     * @param command The command name without the ".md" extension
+     * @return the entry index, or PageArchive::npos if not found
+     */
+    size_t lookup(const std::string_view language, const std::string_view platform,
+                  const std::string_view command) const;
+
+    /* Get the contents of a page
+     * @param i The entry index
+     * @param buf Buffer where compressed pages get decompressed into
+     * @return the page markdown, pointing either into buf or straight into the mapping, or an empty view on error
+     */
+    std::string_view page(const size_t i, std::string& buf) const;
+
+    /* Get a page along with its render tokens
+     * @param i The entry index
+     * @param buf Buffer where compressed pages get decompressed into
+     * @param page Set to the compiled page, pointing either into buf or straight into the mapping
+     * @return false on error
+     */
+    bool compiled(const size_t i, std::string& buf, CompiledPage& page) const;
+
+    // lookup() + page()
+    std::string_view find(const std::string_view language, const std::string_view platform,
+                          const std::string_view command, std::string& buf) const;
+
+    size_t           size() const;
+    std::string_view name(const size_t i) const;
+
+    uint64_t content_hash(const size_t i) const
+    { return this->entries()[i].content_hash; }
+
+    // whether the entry i is a fallback to the page of another platform
+    bool resolved(const size_t i) const
+    { return this->entries()[i].flags & ENTRY_RESOLVED; }
+
+    // the zstd dictionary shared by all the compressed pages
+    std::string_view dictionary() const
+    { return { this->file.data() + this->header()->dict_off, this->header()->dict_size }; }
+
+private:
+    friend class ArchiveWriter;
+
+    const ArchiveHeader* header() const
+    { return reinterpret_cast<const ArchiveHeader*>(this->file.data()); }
+
+    const ArchiveEntry* entries() const
+    { return reinterpret_cast<const ArchiveEntry*>(this->file.data() + this->header()->entries_off); }
+
+    const uint32_t* displacements() const
+    { return reinterpret_cast<const uint32_t*>(this->file.data() + this->header()->index_off); }
+
+    const uint32_t* slots() const
+    { return this->displacements() + this->header()->bucket_count; }
+
+    // the bytes of the entry i as stored in the archive
+    std::string_view blob(const size_t i) const;
+
+    // the compiled page i, decompressed if needed
+    std::string_view stored(const size_t i, std::string& buf) const;
+
+    MappedFile  file;
+    ZSTD_DDict* ddict = nullptr;
+};
+
+constexpr size_t ARCHIVE_SAMPLE_BUDGET = 8 * 1024 * 1024;
+
+/* Writes a page archive in a single pass with bounded memory: pages get compressed and appended as they're added,
+ * only the first ARCHIVE_SAMPLE_BUDGET bytes of pages are held back to train the zstd dictionary.
+ * Pages are deduplicated by their hash_bytes() content hash, once their bytes are checked to be the same.
+ */
+class ArchiveWriter
+{
+public:
+    // Start writing the archive next to path, it only replaces path once finish() is called
+    explicit ArchiveWriter(const std::string_view path);
+
+    // Throw away the archive if it wasn't finished
+    ~ArchiveWriter();
+
+    ArchiveWriter(const ArchiveWriter&)            = delete;
+    ArchiveWriter& operator=(const ArchiveWriter&) = delete;
+
+    // Compress the pages with an existing dictionary instead of training a new one, must be called before add()
+    void set_dictionary(const std::string_view dict);
+
+    /* Add a page, adding the same page twice keeps the last one
+     * @param language The language code (e.g "en", "pt_BR")
+     * @param platform The platform directory name (e.g "linux", "common")
+     * @param command The command name without the ".md" extension
+     * @param content The page content
+     */
+    void add(const std::string_view language, const std::string_view platform, const std::string_view command,
+             const std::string_view content);
+
+    // Add the page i of another archive, without recompressing it if both archives use the same dictionary
+    void copy(const PageArchive& from, const size_t i);
+
+    /* Resolve the missing pages of each platform, write the entries and the index, then replace the archive
+     * @return the number of pages in the archive
+     */
+    size_t finish();
+
+private:
+    struct Blob
+    {
+        uint64_t hash;
+        uint64_t blob_off;
+        uint32_t blob_len;
+        uint32_t page_len;
+        bool     compressed;
+    };
+
+    size_t store(const std::string_view content, const uint64_t hash);
+
+    // whether the blob holds content, held back or read back from the file and decompressed
+    bool holds(const Blob& blob, const std::string_view content);
+    void   write_blob(Blob& blob, const std::string_view content);
+    void   start_compressing();
+
+    // train the dictionary on the pages held back, then write them
+    void flush_pending();
+
+    std::string   path;
+    std::string   tmp_path;
+    std::ofstream f;
+    bool          finished = false;
+    uint64_t      blobs_size = 0;
+
+    // "language/platform/command" -> index in blobs
+    std::map<std::string, size_t>        pages;
+    std::vector<Blob>                    blobs;
+    std::unordered_map<uint64_t, size_t> blobs_by_hash;
+
+    // pages waiting for the dictionary to be trained
+    std::string         samples;
+    std::vector<size_t> sample_sizes;
+    std::vector<size_t> pending;
+
+    std::string dict;
+    bool        dict_ready = false;
+    ZSTD_CCtx*  cctx       = nullptr;
+    ZSTD_CDict* cdict      = nullptr;
+    std::string compressed;
+    std::string compiled;
+
+    // to read back the blobs already written, when a page has the same hash as one of them
+    int         readback = -1;
+    ZSTD_DCtx*  dctx     = nullptr;
+    ZSTD_DDict* ddict    = nullptr;
+};
+
+/* Pack every "<platform>/<command>.md" page found in the pages directories of cache_dir ("pages" and
+ * the "pages.<language>" translations) into a single archive, together with the resolved entries
+ * of the commands missing from each platform
+ * @param cache_dir The tldr cache directory used as import source (e.g getCacheDir())
+ * @param archive_path Where to write the archive, replaced atomically
+ * @return the number of packed pages
+ */
+size_t pack_pages(const std::string_view cache_dir, const std::string_view archive_path);
+
+#endif  // !_ARCHIVE_HPP
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2024 Toni500git
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ * disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _CACHE_HPP
+#define _CACHE_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/* The cache is laid out as immutable generations: getCacheDir()/gen-<N>/ holds everything built from the pages
+ * (the archive and its indexes), and getCacheDir()/current is a symlink to the generation in use.
+ * Writers build a new generation on the side and publish it by atomically renaming a new symlink over current,
+ * so readers always see either the old or the new generation, never a half-updated one.
+ * Readers pin the generation they resolved with a shared flock() on its directory, which never blocks,
+ * and old generations are only removed once nobody holds that lock anymore.
+ */
+
+constexpr std::string_view ARCHIVE_NAME        = "pages.pack";
+constexpr std::string_view MANIFEST_NAME       = "manifest";
+constexpr std::string_view SEARCH_INDEX_NAME   = "search.idx";
+constexpr std::string_view SUGGEST_INDEX_NAME  = "names.idx";
+constexpr std::string_view COMPLETE_INDEX_NAME = "complete.idx";
+
+class CacheGeneration
+{
+public:
+    CacheGeneration() = default;
+    ~CacheGeneration();
+
+    CacheGeneration(const CacheGeneration&)            = delete;
+    CacheGeneration& operator=(const CacheGeneration&) = delete;
+
+    /* Resolve and pin the current generation
+     * @return false if there's no generation yet
+     */
+    bool pin();
+
+    const std::string& path() const
+    { return this->dir; }
+
+    uint64_t id() const
+    { return this->gen; }
+
+private:
+    int         dirfd = -1;
+    uint64_t    gen   = 0;
+    std::string dir;
+};
+
+class GenerationBuilder
+{
+public:
+    // Lock out the other writers and create the directory of the next generation
+    GenerationBuilder();
+
+    // Remove the new generation if it was never committed
+    ~GenerationBuilder();
+
+    GenerationBuilder(const GenerationBuilder&)            = delete;
+    GenerationBuilder& operator=(const GenerationBuilder&) = delete;
+
+    // Directory where the files of the new generation must be written
+    const std::string& path() const
+    { return this->tmp_dir; }
+
+    uint64_t id() const
+    { return this->gen; }
+
+    // Publish the new generation as current and garbage-collect the old ones nobody uses anymore
+    void commit();
+
+private:
+    int         lockfd = -1;
+    bool        committed = false;
+    uint64_t    gen = 0;
+    std::string tmp_dir;
+};
+
+#endif  // !_CACHE_HPP
@@ -0,0 +1,175 @@
+/*
+ * Copyright 2024 Toni500git
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ * disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _COLOR_HPP
+#define _COLOR_HPP
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/* Theme colors can be given as "#rrggbb" (or "#rgb") in the config.
+ * They're turned into SGR escapes once when the config is loaded, already downgraded to what the terminal supports,
+ * so the renderer only ever copies precomputed strings whatever the color depth is.
+ */
+
+enum class ColorDepth
+{
+    ANSI16,
+    ANSI256,
+    TRUECOLOR
+};
+
+constexpr int hex_digit(const char c)
+{
+    return c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+}
+
+/* Parse a "#rrggbb" or "#rgb" color
+ * @param rgb Set to the color as 0xrrggbb
+ * @return false if str isn't a valid color
+ */
+constexpr bool parse_hex_color(const std::string_view str, uint32_t& rgb)
+{
+    if (str.empty() || str[0] != '#' || (str.size() != 7 && str.size() != 4))
+        return false;
+
+    uint32_t value = 0;
+    for (size_t i = 1; i < str.size(); ++i)
+    {
+        const int digit = hex_digit(str[i]);
+        if (digit < 0)
+            return false;
+
+        value = (value << 4) | digit;
+        // #rgb is #rrggbb with every digit doubled
+        if (str.size() == 4)
+            value = (value << 4) | digit;
+    }
+
+    rgb = value;
+    return true;
+}
+
+static_assert([] {
+    uint32_t a = 0, b = 0, c = 0;
+    return parse_hex_color("#1e90ff", a) && a == 0x1e90ff && parse_hex_color("#F0a", b) && b == 0xff00aa &&
+           !parse_hex_color("#12345g", c) && !parse_hex_color("123456", c);
+}());
+
+constexpr uint8_t red(const uint32_t rgb) { return rgb >> 16; }
+constexpr uint8_t green(const uint32_t rgb) { return rgb >> 8; }
+constexpr uint8_t blue(const uint32_t rgb) { return rgb; }
+
+constexpr uint32_t color_distance(const uint32_t a, const uint32_t b)
+{
+    const int dr = red(a) - red(b), dg = green(a) - green(b), db = blue(a) - blue(b);
+    return dr * dr + dg * dg + db * db;
+}
+
+// the 16 ANSI colors, as xterm draws them by default
+constexpr uint32_t ANSI16_PALETTE[16] = {
+    0x000000, 0xcd0000, 0x00cd00, 0xcdcd00, 0x0000ee, 0xcd00cd, 0x00cdcd, 0xe5e5e5,
+    0x7f7f7f, 0xff0000, 0x00ff00, 0xffff00, 0x5c5cff, 0xff00ff, 0x00ffff, 0xffffff,
+};
+
+// the levels of each channel in the 6x6x6 cube of the 256 colors palette
+constexpr uint8_t CUBE_LEVELS[6] = { 0, 95, 135, 175, 215, 255 };
+
+// color of the entry i of the 256 colors palette
+constexpr uint32_t ansi256_color(const size_t i)
+{
+    if (i < 16)
+        return ANSI16_PALETTE[i];
+    if (i < 232)
+        return (CUBE_LEVELS[(i - 16) / 36] << 16) | (CUBE_LEVELS[(i - 16) / 6 % 6] << 8) | CUBE_LEVELS[(i - 16) % 6];
+
+    const uint32_t gray = 8 + (i - 232) * 10;
+    return (gray << 16) | (gray << 8) | gray;
+}
+
+// nearest cube level of every channel value
+constexpr std::array<uint8_t, 256> CUBE_INDEX = [] {
+    std::array<uint8_t, 256> table{};
+    for (size_t v = 0; v < 256; ++v)
+    {
+        uint8_t best = 0;
+        for (uint8_t l = 1; l < 6; ++l)
+            if ((CUBE_LEVELS[l] > v ? CUBE_LEVELS[l] - v : v - CUBE_LEVELS[l]) <
+                (CUBE_LEVELS[best] > v ? CUBE_LEVELS[best] - v : v - CUBE_LEVELS[best]))
+                best = l;
+        table[v] = best;
+    }
+    return table;
+}();
+
+// nearest of the 16 ANSI colors of every entry of the 256 colors palette
+constexpr std::array<uint8_t, 256> ANSI256_TO_16 = [] {
+    std::array<uint8_t, 256> table{};
+    for (size_t i = 0; i < 256; ++i)
+    {
+        if (i < 16)
+        {
+            table[i] = i;
+            continue;
+        }
+
+        uint8_t best = 0;
+        for (uint8_t c = 1; c < 16; ++c)
+            if (color_distance(ansi256_color(i), ANSI16_PALETTE[c]) <
+                color_distance(ansi256_color(i), ANSI16_PALETTE[best]))
+                best = c;
+        table[i] = best;
+    }
+    return table;
+}();
+
+// nearest entry of the 256 colors palette, either in the color cube or in the grayscale ramp
+constexpr uint8_t rgb_to_ansi256(const uint32_t rgb)
+{
+    const uint8_t cube = 16 + CUBE_INDEX[red(rgb)] * 36 + CUBE_INDEX[green(rgb)] * 6 + CUBE_INDEX[blue(rgb)];
+
+    const uint32_t average = (red(rgb) + green(rgb) + blue(rgb)) / 3;
+    const uint8_t  gray    = average < 8 ? 232 : average > 238 ? 255 : 232 + (average - 3) / 10;
+
+    return color_distance(rgb, ansi256_color(gray)) < color_distance(rgb, ansi256_color(cube)) ? gray : cube;
+}
+
+static_assert(rgb_to_ansi256(0xff0000) == 196 && rgb_to_ansi256(0x808080) == 244 && rgb_to_ansi256(0x000000) == 16 &&
+              ANSI256_TO_16[196] == 9 && ANSI256_TO_16[21] == 4 && ANSI256_TO_16[244] == 8);
+
+// the color depth of the terminal, from $COLORTERM and $TERM
+ColorDepth detect_color_depth();
+
+/* Turn a color from the config into the SGR escape for it
+ * @param spec Space separated list of "bold", "italic", "underline" and a "#rrggbb" foreground color
+ * @param depth Colors are downgraded to it
+ * @param out Set to the escape sequence
+ * @return false if spec isn't valid
+ */
+bool color_to_sgr(const std::string_view spec, const ColorDepth depth, std::string& out);
+
+#endif  // !_COLOR_HPP
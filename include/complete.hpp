@@ -0,0 +1,107 @@
+/*
+ * Copyright 2024 Toni500git
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ * disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _COMPLETE_HPP
+#define _COMPLETE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "util.hpp"
+
+constexpr char     COMPLETE_MAGIC[4] = { 'W', 'R', 'P', 'C' };
+constexpr uint32_t COMPLETE_VERSION  = 1;
+
+// names per front coded block, bigger blocks are smaller on disk but need more decoding per lookup
+constexpr size_t COMPLETE_BLOCK_SIZE = 16;
+
+/* Sorted table of the commands of the current platform (common and the other platforms included, as the archive
+ * resolved them), to complete page names from the shell without listing any directory.
+ * It's built along with the archive and stored next to it in the cache generation (see cache.hpp):
+ *   CompleteHeader | uint32_t block_off[block_count] | blocks
+ * Names are "language/command" and front coded in blocks of COMPLETE_BLOCK_SIZE: the first name of a block is
+ * stored whole (varint length + bytes), the next ones as the varint length of the prefix shared with the previous
+ * name, the varint length of the rest, and the rest. Finding a prefix is a binary search over the first names
+ * of the blocks, then decoding forward from there until the names stop matching.
+ */
+struct CompleteHeader
+{
+    char     magic[4];
+    uint32_t version;
+    uint32_t name_count;
+    uint32_t block_count;
+    uint64_t blocks_off;
+    uint64_t file_size;
+};
+
+class CompleteIndex
+{
+public:
+    CompleteIndex() = default;
+    ~CompleteIndex();
+
+    CompleteIndex(const CompleteIndex&)            = delete;
+    CompleteIndex& operator=(const CompleteIndex&) = delete;
+
+    bool open(const std::string_view path);
+    void close();
+
+    /* Find the commands starting with a prefix
+     * @param language The language code (e.g "en", "pt_BR")
+     * @param prefix The start of the command name, empty for all of them
+     * @param commands Where to append the commands, in order
+     * @return false if the index is corrupted
+     */
+    bool complete(const std::string_view language, const std::string_view prefix,
+                  std::vector<std::string>& commands) const;
+
+private:
+    const CompleteHeader* header() const
+    { return reinterpret_cast<const CompleteHeader*>(this->file.data()); }
+
+    const uint32_t* block_offsets() const
+    { return reinterpret_cast<const uint32_t*>(this->file.data() + sizeof(CompleteHeader)); }
+
+    // the first name of a block, empty if it's out of bounds
+    std::string_view block_head(const size_t block) const;
+
+    MappedFile  file;
+};
+
+/* Build the completion index of the archive of a cache generation
+ * @param generation_dir The directory of the generation, where the index is written next to the archive
+ * @return the number of names indexed
+ */
+size_t build_complete_index(const std::string_view generation_dir);
+
+/* Print the commands starting with prefix, one per line, in the languages of the user
+ * @return false if there's no completion index
+ */
+bool complete_pages(const std::string_view generation_dir, const std::string_view prefix);
+
+#endif  // !_COMPLETE_HPP
@@ -3,19 +3,72 @@
 
 #define TOML_HEADER_ONLY 0
 
+#include "color.hpp"
 #include "toml++/toml.hpp"
 #include "util.hpp"
 
+constexpr std::string_view DEFAULT_CLR_TITLE        = "\033[1m";
+constexpr std::string_view DEFAULT_CLR_DESCRIPTION  = "\033[34m";
+constexpr std::string_view DEFAULT_CLR_EXAMPLE_TEXT = "\033[36m";
+constexpr std::string_view DEFAULT_CLR_EXAMPLE_CODE = "\033[33m";
+
+/* Everything the renderer emits that depends on the colors, already concatenated.
+ * The renderer is a template over the theme type, so the default colors get baked in at compile time
+ * with DefaultTheme, and custom ones go through a Theme precomputed when loading the config.
+ */
+struct Theme
+{
+    std::string title;             // "  " + clr_title
+    std::string description;       // "  " + clr_description
+    std::string example;           // "  -" + clr_example_text + " "
+    std::string code;              // "  \t" + clr_example_code
+    std::string placeholder_end;   // NOCOLOR + clr_example_code
+};
+
+struct DefaultTheme
+{
+    static constexpr std::string_view title           = "  \033[1m";
+    static constexpr std::string_view description     = "  \033[34m";
+    static constexpr std::string_view example         = "  -\033[36m ";
+    static constexpr std::string_view code            = "  \t\033[33m";
+    static constexpr std::string_view placeholder_end = "\033[0m\033[33m";
+};
+
+static_assert(DefaultTheme::title.substr(2) == DEFAULT_CLR_TITLE &&
+                  DefaultTheme::description.substr(2) == DEFAULT_CLR_DESCRIPTION &&
+                  DefaultTheme::example.substr(3, DEFAULT_CLR_EXAMPLE_TEXT.size()) == DEFAULT_CLR_EXAMPLE_TEXT &&
+                  DefaultTheme::code.substr(3) == DEFAULT_CLR_EXAMPLE_CODE &&
+                  DefaultTheme::placeholder_end.substr(4) == DEFAULT_CLR_EXAMPLE_CODE,
+              "DefaultTheme must match the default colors");
+
 class Config
 {
 public:
     Config(const std::string_view configFile, const std::string_view configDir);
 
+    // colors written as "#rrggbb" are downgraded to it
+    ColorDepth color_depth;
+
     std::string clr_title;
     std::string clr_description;
     std::string clr_example_text;
     std::string clr_example_code;
 
+    // the colors above, precomputed for the renderer
+    Theme theme;
+
+    // whether the colors are the default ones, so DefaultTheme can be used instead of theme
+    bool default_theme;
+
+    std::string update_index_url;
+    std::string update_pages_url;
+    std::string update_archive_url;
+
+    bool     cache_rendered;
+    uint64_t cache_rendered_max_size;
+
+    bool pager;
+
 private:
     void        loadConfigFile(const std::string_view filename);
     void        generateConfig(const std::string_view filename);
@@ -35,11 +88,38 @@ private:
 };
 
 inline constexpr std::string_view AUTOCONFIG = R"#([colors]
+# The colors are either escape sequences, or a "#rrggbb" color optionally preceded by "bold", "italic" or "underline"
+# e.g example-code = "bold #ffa500"
 title = "\e[1m"
 description = "\e[34m"
 example-text = "\e[36m"
 example-code = "\e[33m"
 
+# Colors supported by the terminal, the "#rrggbb" colors are converted to the nearest one it can show.
+# "auto" detects it from $COLORTERM and $TERM, else one of "truecolor", "256" or "16"
+depth = "auto"
+
+[update]
+# Where "wrapup --update" gets the list of pages with their hashes (a GitHub git tree)
+index-url = "https://api.github.com/repos/tldr-pages/tldr/git/trees/main?recursive=1"
+
+# Base URL the pages are downloaded from, followed by their path (e.g "pages/linux/tar.md")
+pages-url = "https://raw.githubusercontent.com/tldr-pages/tldr/refs/heads/main"
+
+# Zip with every page, used instead of pages-url when there are too many pages to download
+archive-url = "https://github.com/tldr-pages/tldr/releases/latest/download/tldr.zip"
+
+[output]
+# Show the output in the built-in pager when it doesn't fit in the terminal
+pager = false
+
+[cache]
+# Keep the pages once rendered, so showing them again is a single copy to the terminal
+rendered = false
+
+# Maximum size in bytes of the rendered pages, the least recently used ones get removed first
+rendered-max-size = 4194304
+
 )#";
 
 #endif
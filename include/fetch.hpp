@@ -0,0 +1,61 @@
+/*
+ * Copyright 2024 Toni500git
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ * disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _FETCH_HPP
+#define _FETCH_HPP
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// how long a url that answered 404 is assumed to still not exist
+constexpr std::chrono::seconds MISS_TTL = std::chrono::hours(24);
+
+// size of the copies kept under getCacheDir()/http, a few pages indexes
+constexpr uint64_t HTTP_CACHE_MAX_SIZE = 32 * 1024 * 1024;
+
+/* Download url, revalidating the copy kept from the last download instead of fetching it again.
+ * The copy is stored under getCacheDir()/http along with its ETag and Last-Modified validators,
+ * which get sent back as If-None-Match and If-Modified-Since: a 304 answer only costs a round trip of headers.
+ * Past HTTP_CACHE_MAX_SIZE, the copies used the least recently are removed.
+ * @param url The url to download
+ * @param out Where to put the body
+ * @param status Set to the HTTP status code (a revalidated copy reports 304)
+ * @return true if out holds the body
+ */
+bool fetch_url(const std::string_view url, std::string& out, long& status);
+
+/* Negative cache of the urls which answered 404, so lookups of commands without a page
+ * (typos, scripts probing many commands) fail without going through the network.
+ * It's a small sorted list of "<expiry> <url>" lines in getCacheDir()/misses, expired entries are dropped on write.
+ */
+bool is_known_miss(const std::string_view url);
+void remember_miss(const std::string_view url);
+
+// Forget every miss, e.g after an update which may have brought new pages
+void clear_misses();
+
+#endif  // !_FETCH_HPP
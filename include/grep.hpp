@@ -0,0 +1,49 @@
+/*
+ * Copyright 2024 Toni500git
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ * disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _GREP_HPP
+#define _GREP_HPP
+
+#include <string>
+#include <string_view>
+
+#include "archive.hpp"
+#include "config.hpp"
+#include "output.hpp"
+
+/* Find a literal that every match of a regex (ECMAScript syntax) must contain, so the text that can't match gets
+ * skipped with a plain substring search before running the regex on it.
+ * Only the top level of the pattern is looked at: groups, classes and anything quantified are left out.
+ * @return the longest such literal, empty if there's none (e.g the pattern has an alternation)
+ */
+std::string required_literal(const std::string_view pattern);
+
+/* Show the example code lines matching a regex, across the english pages of every platform.
+ * The pages are searched on every core, and the matches written to out in archive order, as soon as they're found.
+ * @return false if nothing matched
+ */
+bool grep_pages(const std::string_view pattern, const Config& config, const PageArchive& archive, OutputSink& out);
+
+#endif  // !_GREP_HPP
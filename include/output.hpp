@@ -0,0 +1,125 @@
+/*
+ * Copyright 2024 Toni500git
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ * disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _OUTPUT_HPP
+#define _OUTPUT_HPP
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/* Where rendered output goes. Segments are gathered and written in batches (with writev() for file descriptors),
+ * and once the reader is gone (EPIPE) every write returns false, so whatever produces the output can stop early
+ * instead of rendering for nobody.
+ */
+class OutputSink
+{
+public:
+    virtual ~OutputSink() = default;
+
+    /* Queue a segment, taking it over so it doesn't get copied
+     * @return false if the output is closed
+     */
+    bool write(std::string&& segment);
+
+    // Queue a copy of data
+    bool write(const std::string_view data);
+
+    /* Copy size bytes of a file, from its current offset
+     * @return false if the output is closed or the file couldn't be read
+     */
+    virtual bool write_file(const int in_fd, const size_t size);
+
+    /* Write everything queued so far
+     * @return false if the output is closed
+     */
+    virtual bool flush() = 0;
+
+    /* Called once everything got written
+     * @return false if the output is closed
+     */
+    virtual bool finish()
+    { return this->flush(); }
+
+    // Columns to wrap the output at, 0 if it shouldn't be wrapped
+    virtual size_t width() const
+    { return 0; }
+
+    bool closed() const
+    { return this->is_closed; }
+
+protected:
+    // flush once this much is queued
+    static constexpr size_t FLUSH_THRESHOLD = 64 * 1024;
+
+    // Called after a segment got queued, flushes when there's enough of them
+    virtual bool queued();
+
+    std::vector<std::string> segments;
+    size_t                   pending   = 0;
+    bool                     is_closed = false;
+};
+
+// Writes to a file descriptor: a terminal, a file, a pipe to a pager, a socket...
+class FdSink : public OutputSink
+{
+public:
+    explicit FdSink(const int fd);
+    ~FdSink() override;
+
+    bool   write_file(const int in_fd, const size_t size) override;
+    bool   flush() override;
+    size_t width() const override
+    { return this->columns; }
+
+private:
+    int    fd;
+    size_t columns;
+};
+
+// Keeps everything in memory
+class MemorySink : public OutputSink
+{
+public:
+    // columns is what width() reports, to render for another sink
+    explicit MemorySink(const size_t columns = 0)
+        : columns(columns)
+    {}
+
+    bool   flush() override;
+    size_t width() const override
+    { return this->columns; }
+
+    // everything written so far, after flush()
+    const std::string& str() const
+    { return this->data; }
+
+private:
+    std::string data;
+    size_t      columns;
+};
+
+#endif  // !_OUTPUT_HPP
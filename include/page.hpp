@@ -0,0 +1,106 @@
+/*
+ * Copyright 2024 Toni500git
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ * disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _PAGE_HPP
+#define _PAGE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/* Pages are compiled once, when they get packed, into a list of typed tokens so rendering doesn't scan the markdown.
+ * Each token is an escape to emit (which depends on its kind) followed by a slice of the markdown.
+ * A compiled page is stored as:
+ *   markdown | padding to 4 bytes | PageToken[token_count] | uint32_t token_count | uint32_t markdown_size
+ * so the markdown stays readable as it is, for everything else than rendering.
+ */
+enum PageTokenKind : uint8_t
+{
+    // a token of these kinds starts a new line
+    TOKEN_TITLE,        // "# title"
+    TOKEN_DESCRIPTION,  // "> description"
+    TOKEN_EXAMPLE,      // "- example description"
+    TOKEN_CODE,         // "`example code`", up to the first closing backtick or placeholder
+    TOKEN_TEXT,         // any other line
+
+    // and these continue a TOKEN_CODE line
+    TOKEN_CODE_END,         // after the closing backtick
+    TOKEN_PLACEHOLDER,      // after a "{{"
+    TOKEN_PLACEHOLDER_END,  // after a "}}" closing a placeholder
+};
+
+struct PageToken
+{
+    uint32_t offset;  // of the slice in the markdown
+    uint32_t length : 24;
+    uint32_t kind : 8;
+};
+
+// a compiled page as stored, tokens aren't necessarily aligned
+struct CompiledPage
+{
+    std::string_view markdown;
+    const char*      tokens = nullptr;
+    size_t           token_count = 0;
+
+    PageToken token(const size_t i) const
+    {
+        PageToken token;
+        std::memcpy(&token, this->tokens + i * sizeof(PageToken), sizeof(PageToken));
+        return token;
+    }
+
+    std::string_view text(const PageToken& token) const
+    { return this->markdown.substr(token.offset, token.length); }
+};
+
+/* Find every backtick, "{{" and "}}" (overlapping ones included, e.g twice in "{{{") in one pass,
+ * with SSE2 or AVX2 when the CPU has it
+ * @param data The text to scan, a page or a whole corpus
+ * @param offsets Where to append the offset of each marker, in order
+ */
+void scan_markers(const std::string_view data, std::vector<uint32_t>& offsets);
+
+/* Tokenize the markdown of a page
+ * @param content The markdown
+ * @param tokens Where to append the tokens
+ */
+void compile_page(const std::string_view content, std::vector<PageToken>& tokens);
+
+/* Compile a page into its stored form
+ * @param content The markdown
+ * @param out Where to put the compiled page
+ */
+void compile_page(const std::string_view content, std::string& out);
+
+/* Read a compiled page in its stored form
+ * @return false if it's truncated or the tokens point out of the markdown
+ */
+bool read_compiled_page(const std::string_view data, CompiledPage& page);
+
+#endif  // !_PAGE_HPP
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2024 Toni500git
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ * disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _PAGER_HPP
+#define _PAGER_HPP
+
+#include <termios.h>
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "output.hpp"
+
+/* In-process pager, used as the output when it's longer than the terminal.
+ * As soon as there's a screenful of lines, write() shows it and waits for the user, and only returns to take more
+ * once the user scrolls past what was written so far. It's lazy by whole pages, not by screens: the pages come
+ * rendered, and show_pages() only renders a few of them ahead of what was shown.
+ * Quitting closes the output, so nothing more gets rendered.
+ * Without a terminal to read the keys from, everything is just printed.
+ * Lines are written unwrapped and wrapped when displayed, so a terminal resize (SIGWINCH) just re-wraps them.
+ */
+class Pager : public OutputSink
+{
+public:
+    // The output must be a terminal, keys are read from /dev/tty
+    Pager();
+    ~Pager() override;
+
+    bool flush() override;
+
+    // Show what was written until the user quits, or just print it if it fits in the terminal
+    bool finish() override;
+
+protected:
+    bool queued() override;
+
+private:
+    struct Row
+    {
+        size_t      line;  // index of the line it's a part of
+        std::string text;
+    };
+
+    // move the queued segments into lines, and wrap them
+    void ingest();
+    void wrap(const size_t first_line);
+    void resize();
+    void draw();
+
+    /* Print the rows as they are and drop them, when there's nothing to page
+     * @return false if the output is closed
+     */
+    bool print_rows();
+
+    // enter the terminal in the pager mode (alternate screen, no echo), and leave it
+    void enter();
+    void leave();
+
+    /* Handle keys until the user quits, or scrolls past the end while more can be written
+     * @return false if the user quit
+     */
+    bool interact();
+
+    std::vector<std::string> lines;
+    std::string              partial;  // last line, until its newline gets written
+    std::vector<Row>         rows;
+    size_t                   top = 0;
+    size_t                   screen_rows = 24;
+    size_t                   screen_cols = 80;
+    bool                     more = true;  // whether more can still be written
+    bool                     to_end = false;
+    bool                     active = false;
+    int                      tty = -1;
+    FdSink                   stdout_sink;
+    struct termios           saved_termios;
+};
+
+#endif  // !_PAGER_HPP
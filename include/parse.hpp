@@ -27,10 +27,36 @@
 #define _PARSE_HPP
 
 #include <string>
+#include <string_view>
+#include <vector>
 
+#include "archive.hpp"
 #include "config.hpp"
+#include "output.hpp"
 
 std::string get_platform();
-void parse_page(const std::string_view page, const Config& config);
+std::vector<std::string> get_languages();
+
+/* Pages of another platform are flagged in the listings, they may not apply here
+ * @param platform The platform directory of a page
+ * @return " (platform)" if it's neither get_platform() nor common, else an empty string
+ */
+std::string platform_tag(const std::string_view platform);
+
+enum class ParseResult
+{
+    RENDERED,
+    NOT_FOUND,
+    FAILED,  // already reported, e.g the download failed
+    CLOSED   // the output got closed (e.g piped into "head"), nothing more should be rendered then
+};
+
+/* Render a page, looking for it in the archive, then in the pages directories, then online.
+ * Safe to call from several threads at once, with a different out each.
+ * @param page The command name
+ * @param out Where to write the rendered page
+ */
+ParseResult parse_page(const std::string_view page, const Config& config, const PageArchive& archive,
+                       OutputSink& out);
 
 #endif // !_PARSE_HPP
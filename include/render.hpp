@@ -0,0 +1,54 @@
+/*
+ * Copyright 2024 Toni500git
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ * disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _RENDER_HPP
+#define _RENDER_HPP
+
+#include <string>
+#include <string_view>
+
+#include "config.hpp"
+#include "page.hpp"
+
+/* Render a compiled page for the terminal: a straight walk over its tokens, emitting the escapes of the theme
+ * and slices of the markdown, appended to out, which only grows once per page instead of once per line.
+ * @param page The compiled page
+ * @param config The colors to use
+ * @param width Columns to soft wrap the lines at, with a hanging indent, 0 to never wrap them
+ * @param out Where to append the rendered page
+ */
+void render_page(const CompiledPage& page, const Config& config, const size_t width, std::string& out);
+
+// Same, for a page that wasn't compiled yet (e.g not from the archive)
+void render_page(const std::string_view content, const Config& config, const size_t width, std::string& out);
+
+/* Soft wrap a line which was rendered without wrapping, as if it was rendered with width columns
+ * @param line The line, without its newline
+ * @param width Columns to wrap it at
+ * @param out Where to write the wrapped line, continuation lines being separated by newlines
+ */
+void wrap_rendered_line(const std::string_view line, const size_t width, std::string& out);
+
+#endif  // !_RENDER_HPP
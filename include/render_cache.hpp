@@ -0,0 +1,78 @@
+/*
+ * Copyright 2024 Toni500git
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ * disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _RENDER_CACHE_HPP
+#define _RENDER_CACHE_HPP
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "config.hpp"
+#include "output.hpp"
+
+/* Cache of fully rendered pages in getCacheDir()/rendered, enabled with cache.rendered in the config.
+ * Entries are keyed by everything the output depends on: the content hash of the page, the hash of the theme,
+ * and the width and color depth of the terminal. So a page changed by a new generation or a theme changed
+ * in config.toml just never hits the old entries again, and they end up evicted.
+ * The modification time of an entry is its last use, once the cache grows over cache.rendered-max-size
+ * the least recently used entries are removed.
+ */
+class RenderCache
+{
+public:
+    /* @param config The config with the theme
+     * @param width The width the pages get wrapped at
+     */
+    RenderCache(const Config& config, const size_t width);
+
+    enum class SendResult
+    {
+        SENT,
+        NOT_CACHED,    // nothing was written then
+        WRITE_FAILED   // part of the page may have been written already
+    };
+
+    /* Send the cached rendering of a page to the output, with sendfile() when possible
+     * @param content_hash The content hash of the page
+     * @return SendResult::WRITE_FAILED if it was cached but writing it to out failed
+     */
+    SendResult send(const uint64_t content_hash, OutputSink& out) const;
+
+    /* Cache the rendering of a page
+     * @param content_hash The content hash of the page
+     * @param output The rendered page
+     */
+    void store(const uint64_t content_hash, const std::string_view output) const;
+
+private:
+    std::string entry_path(const uint64_t content_hash) const;
+
+    std::string dir;
+    uint64_t    max_size;
+    uint64_t    key_seed;
+};
+
+#endif  // !_RENDER_CACHE_HPP
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2024 Toni500git
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ * disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _SEARCH_HPP
+#define _SEARCH_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "archive.hpp"
+#include "config.hpp"
+#include "output.hpp"
+#include "util.hpp"
+
+constexpr char     SEARCH_MAGIC[4] = { 'W', 'R', 'P', 'S' };
+constexpr uint32_t SEARCH_VERSION  = 2;
+
+// at most this many pages are listed by a search, the best ranked ones
+constexpr size_t MAX_SEARCH_RESULTS = 25;
+
+/* Full-text index over the titles, descriptions and example descriptions of the pages of an archive,
+ * built along with it and stored next to it in the cache generation (see cache.hpp):
+ *   SearchHeader | SearchTerm[term_count] | uint32_t length[entry_count] | term strings | postings
+ * Terms are sorted, so finding one is a binary search over the term table. The postings of a term list the pages
+ * it appears in, by increasing archive entry index: each one is the varint encoded difference with the previous
+ * entry, followed by the varint frequency of the term in the page.
+ * Frequencies and page lengths are weighted by the section the words are in (see WEIGHT_TITLE...): along with the
+ * number of pages of each term, they're everything BM25 needs, so ranking doesn't open a single page.
+ * The file is mmap()ed, so a query only pages in the terms it looks up and their postings, however big the index is.
+ */
+struct SearchHeader
+{
+    char     magic[4];
+    uint32_t version;
+    uint32_t entry_count;  // of the archive it was built from
+    uint32_t term_count;
+    uint32_t page_count;  // indexed, the fallbacks aren't
+    uint32_t reserved;
+    uint64_t total_length;
+    uint64_t terms_off;
+    uint64_t lengths_off;
+    uint64_t strings_off;
+    uint64_t postings_off;
+    uint64_t file_size;
+};
+
+struct SearchTerm
+{
+    uint32_t str_off;
+    uint32_t str_len;
+    uint32_t page_count;
+    uint32_t postings_len;
+    uint64_t postings_off;
+};
+
+// how many times a word counts, depending on where it is in the page
+constexpr uint32_t WEIGHT_TITLE       = 4;
+constexpr uint32_t WEIGHT_DESCRIPTION = 2;
+constexpr uint32_t WEIGHT_EXAMPLE     = 1;
+
+struct SearchMatch
+{
+    uint32_t entry;
+    float    score;
+};
+
+/* Split a text into lowercase search terms, skipping the <links>
+ * @param terms Where to append the terms
+ */
+void split_terms(const std::string_view text, std::vector<std::string>& terms);
+
+class SearchIndex
+{
+public:
+    SearchIndex() = default;
+    ~SearchIndex();
+
+    SearchIndex(const SearchIndex&)            = delete;
+    SearchIndex& operator=(const SearchIndex&) = delete;
+
+    /* Open the index of an archive
+     * @return false if it's missing, corrupted, or wasn't built from that archive
+     */
+    bool open(const std::string_view path, const PageArchive& archive);
+    void close();
+
+    /* Find the pages having every term of the query
+     * @return the archive entries of the pages, with their BM25 score
+     */
+    std::vector<SearchMatch> search(const std::string_view query) const;
+
+private:
+    const SearchHeader* header() const
+    { return reinterpret_cast<const SearchHeader*>(this->file.data()); }
+
+    const SearchTerm* terms() const
+    { return reinterpret_cast<const SearchTerm*>(this->file.data() + this->header()->terms_off); }
+
+    const uint32_t* lengths() const
+    { return reinterpret_cast<const uint32_t*>(this->file.data() + this->header()->lengths_off); }
+
+    std::string_view term(const SearchTerm& term) const
+    { return { this->file.data() + this->header()->strings_off + term.str_off, term.str_len }; }
+
+    // the entry in the term table, or nullptr if no page has it
+    const SearchTerm* find(const std::string_view term) const;
+
+    MappedFile  file;
+};
+
+/* Build the search index of the archive of a cache generation
+ * @param generation_dir The directory of the generation, where the index is written next to the archive
+ * @return the number of terms indexed
+ */
+size_t build_search_index(const std::string_view generation_dir);
+
+/* Show the MAX_SEARCH_RESULTS best pages matching a query, one line per command: its name and description
+ * @return false if nothing matched
+ */
+bool search_pages(const std::string_view query, const Config& config, const PageArchive& archive,
+                  const SearchIndex& index, OutputSink& out);
+
+#endif  // !_SEARCH_HPP
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2024 Toni500git
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ * disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _SUGGEST_HPP
+#define _SUGGEST_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "util.hpp"
+
+constexpr char     SUGGEST_MAGIC[4] = { 'W', 'R', 'P', 'N' };
+constexpr uint32_t SUGGEST_VERSION  = 1;
+
+// at most this many suggestions are given for a page that wasn't found
+constexpr size_t MAX_SUGGESTIONS = 5;
+
+/* BK-tree over the names of every command of an archive, to suggest the closest ones to a page that wasn't found.
+ * It's built along with the archive and stored next to it in the cache generation (see cache.hpp):
+ *   SuggestHeader | SuggestNode[node_count] | SuggestEdge[edge_count] | names
+ * Node 0 is the root. The children of a node are edges[first_child .. first_child + child_count], sorted by
+ * the edit distance between the node and the child: by the triangle inequality, the names within k edits of a query
+ * at distance d of a node are all under the children at distance d - k to d + k, the rest of the tree is skipped.
+ * So a lookup only computes the distance to a small part of the names, however many pages there are.
+ */
+struct SuggestHeader
+{
+    char     magic[4];
+    uint32_t version;
+    uint32_t node_count;
+    uint32_t edge_count;
+    uint64_t nodes_off;
+    uint64_t edges_off;
+    uint64_t names_off;
+    uint64_t file_size;
+};
+
+struct SuggestNode
+{
+    uint32_t name_off;
+    uint16_t name_len;
+    uint16_t child_count;
+    uint32_t first_child;
+};
+
+struct SuggestEdge
+{
+    uint32_t distance;
+    uint32_t node;
+};
+
+/* Levenshtein distance between two strings, with Myers' bit-parallel algorithm:
+ * a whole column of the edit matrix is updated at once in a 64 bits word, for names up to 64 characters
+ */
+size_t edit_distance(const std::string_view a, const std::string_view b);
+
+class SuggestIndex
+{
+public:
+    SuggestIndex() = default;
+    ~SuggestIndex();
+
+    SuggestIndex(const SuggestIndex&)            = delete;
+    SuggestIndex& operator=(const SuggestIndex&) = delete;
+
+    bool open(const std::string_view path);
+    void close();
+
+    /* Find the names closest to a command
+     * @param command The command that wasn't found
+     * @return up to MAX_SUGGESTIONS names, closest first
+     */
+    std::vector<std::string_view> suggest(const std::string_view command) const;
+
+private:
+    const SuggestHeader* header() const
+    { return reinterpret_cast<const SuggestHeader*>(this->file.data()); }
+
+    const SuggestNode* nodes() const
+    { return reinterpret_cast<const SuggestNode*>(this->file.data() + this->header()->nodes_off); }
+
+    const SuggestEdge* edges() const
+    { return reinterpret_cast<const SuggestEdge*>(this->file.data() + this->header()->edges_off); }
+
+    MappedFile  file;
+};
+
+/* Build the suggestions index of the archive of a cache generation
+ * @param generation_dir The directory of the generation, where the index is written next to the archive
+ * @return the number of names indexed
+ */
+size_t build_suggest_index(const std::string_view generation_dir);
+
+#endif  // !_SUGGEST_HPP
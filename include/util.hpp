@@ -29,8 +29,10 @@
 #include <dlfcn.h>
 #include <sys/types.h>
 
+#include <cstdint>
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include "fmt/color.h"
@@ -60,12 +62,55 @@ void         replace_str(std::string& str, const std::string_view from, const st
 bool         read_exec(std::vector<const char*> cmd, std::string& output, bool useStdErr = false, bool noerror_print = true);
 std::string  str_tolower(std::string str);
 std::string  str_toupper(std::string str);
-fmt::rgb     hexStringToColor(const std::string_view hexstr);
 std::string  getHomeCacheDir();
 std::string  getCacheDir();
 std::string  getHomeConfigDir();
 std::string  getConfigDir();
 std::vector<std::string> split(const std::string_view text, char delim);
+bool         read_file(const std::string_view path, std::string& out);
+size_t       get_terminal_width(const int fd);
+uint64_t     hash_bytes(const void* data, const size_t len, uint64_t seed = 0);
+std::string  temp_path(const std::string_view path);
+bool         replace_file(const std::string_view path, const std::string_view data);
+void         evict_least_recently_used(const std::string_view dir, const uint64_t max_size);
+void         write_varint(std::string& out, uint32_t value);
+bool         read_varint(const std::string_view data, size_t& i, uint32_t& value);
+
+// A whole file mmap()ed read-only, for the archive and its indexes which are read in place
+class MappedFile
+{
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&)            = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /* Map a file
+     * @param min_size Files smaller than this (e.g their header) are rejected
+     * @return false if it's missing, too small or can't be mapped
+     */
+    bool open(const std::string_view path, const size_t min_size);
+    void close();
+
+    /* Check the magic and version every format starts with
+     * @return false if the file isn't of that format, or of another version of it
+     */
+    bool has_header(const char (&magic)[4], const uint32_t version) const;
+
+    bool is_open() const
+    { return this->map != nullptr; }
+
+    const char* data() const
+    { return this->map; }
+
+    size_t size() const
+    { return this->map_size; }
+
+private:
+    const char* map = nullptr;
+    size_t      map_size = 0;
+};
 
 
 #define BOLD_COLOR(x) (fmt::emphasis::bold | fmt::fg(x))
@@ -0,0 +1,102 @@
+/*
+ * Copyright 2024 Toni500git
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ * disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _ZIP_HPP
+#define _ZIP_HPP
+
+#include <zlib.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+/* Decodes a zip archive while it's still being downloaded, only looking at the local file headers.
+ * Memory stays bounded whatever the size of the archive: the bytes of the chunk being fed,
+ * the inflate window and the file being decompressed.
+ */
+class ZipStream
+{
+public:
+    // called for every file of the archive, content is only valid during the call
+    using Callback = std::function<void(const std::string_view name, const std::string_view content)>;
+
+    /* @param callback What to do with each file
+     * @param max_file_size Files bigger than this are skipped (pages are only a few KiB)
+     */
+    explicit ZipStream(Callback callback, const size_t max_file_size = 1024 * 1024);
+    ~ZipStream();
+
+    ZipStream(const ZipStream&)            = delete;
+    ZipStream& operator=(const ZipStream&) = delete;
+
+    /* Decode the next bytes of the archive
+     * @param data The next chunk
+     * @return false if the archive is invalid or uses something unsupported, see error()
+     */
+    bool feed(const std::string_view data);
+
+    // whether the central directory was reached, which means every file got decoded
+    bool done() const
+    { return this->state == State::DONE; }
+
+    const std::string& error() const
+    { return this->err; }
+
+private:
+    enum class State
+    {
+        HEADER,
+        DATA,
+        DESCRIPTOR,
+        DONE,
+        ERROR
+    };
+
+    size_t fail(const std::string_view msg);
+    void   append(const char* data, const size_t len);
+    void   finish_file();
+    size_t read_header(const std::string_view in);
+    size_t read_data(const std::string_view in);
+
+    Callback    callback;
+    size_t      max_file_size;
+    State       state = State::HEADER;
+    std::string buf;
+    std::string err;
+
+    // the file being decoded
+    std::string name;
+    std::string content;
+    uint16_t    flags     = 0;
+    uint16_t    method    = 0;
+    uint32_t    comp_size = 0;
+    uint32_t    consumed  = 0;
+    bool        skip      = false;
+    z_stream    zs{};
+};
+
+#endif  // !_ZIP_HPP
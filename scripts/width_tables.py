@@ -0,0 +1,81 @@
+#!/usr/bin/env python3
+# Regenerate ZERO_WIDTH_RANGES and WIDE_RANGES in include/width.hpp from the Unicode data of this Python,
+# e.g "python3.13 scripts/width_tables.py" for Unicode 15.1
+#
+# zero width: nonspacing and enclosing marks (Mn, Me), format characters (Cf) but the prepended concatenation marks
+#             which are drawn, and the Hangul medial vowels and final consonants (U+1160..U+11FF) which join the
+#             syllable before them
+# wide:       East Asian Wide (W) and Fullwidth (F), including the unassigned codepoints of the CJK ideograph blocks
+#             that EastAsianWidth.txt defaults to W
+# Everything below U+0300 is left to the fast path of codepoint_width().
+
+import os
+import re
+import sys
+import unicodedata
+
+FIRST = 0x300
+# PropList.txt Prepended_Concatenation_Mark, not in unicodedata
+PREPENDED_MARKS = [(0x0600, 0x0605), (0x06DD, 0x06DD), (0x070F, 0x070F), (0x0890, 0x0891), (0x08E2, 0x08E2),
+                   (0x110BD, 0x110BD), (0x110CD, 0x110CD)]
+CJK_BLOCKS = [(0x3400, 0x4DBF), (0x4E00, 0x9FFF), (0xF900, 0xFAFF), (0x20000, 0x2FFFD), (0x30000, 0x3FFFD)]
+
+
+def is_zero_width(cp):
+    if any(first <= cp <= last for first, last in PREPENDED_MARKS):
+        return False
+    return unicodedata.category(chr(cp)) in ("Mn", "Me", "Cf") or 0x1160 <= cp <= 0x11FF
+
+
+def is_wide(cp):
+    if unicodedata.east_asian_width(chr(cp)) in ("W", "F"):
+        return True
+    return unicodedata.category(chr(cp)) == "Cn" and any(first <= cp <= last for first, last in CJK_BLOCKS)
+
+
+def ranges(pred):
+    out = []
+    for cp in range(FIRST, sys.maxunicode + 1):
+        if not pred(cp):
+            continue
+        if out and out[-1][1] == cp - 1:
+            out[-1][1] = cp
+        else:
+            out.append([cp, cp])
+    return out
+
+
+def table(name, rs):
+    items = ["{{ 0x{:04X}, 0x{:04X} }},".format(first, last) for first, last in rs]
+    lines, line = [], "   "
+    for item in items:
+        if len(line) + 1 + len(item) > 120:
+            lines.append(line)
+            line = "   "
+        line += " " + item
+    lines.append(line)
+    return "constexpr CodepointRange {}[] = {{\n{}\n}};".format(name, "\n".join(lines))
+
+
+def main():
+    path = os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "include", "width.hpp")
+    with open(path) as f:
+        src = f.read()
+
+    zero = ranges(is_zero_width)
+    wide = ranges(lambda cp: is_wide(cp) and not is_zero_width(cp))
+    tables = "{}\n\n{}".format(table("ZERO_WIDTH_RANGES", zero), table("WIDE_RANGES", wide))
+
+    src = re.sub(r"constexpr CodepointRange ZERO_WIDTH_RANGES\[\] = \{.*?\n\};\n\nconstexpr CodepointRange WIDE_RANGES\[\] = \{.*?\n\};",
+                 lambda _: tables, src, count=1, flags=re.S)
+    src = re.sub(r"Generated by scripts/width_tables.py from the Unicode [0-9.]+ data",
+                 "Generated by scripts/width_tables.py from the Unicode {} data".format(unicodedata.unidata_version),
+                 src, count=1)
+    with open(path, "w") as f:
+        f.write(src)
+
+    print("Unicode {}: {} zero width ranges, {} wide ranges".format(unicodedata.unidata_version, len(zero), len(wide)))
+
+
+if __name__ == "__main__":
+    main()
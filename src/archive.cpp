@@ -0,0 +1,649 @@
+/*
+ * Copyright 2024 Toni500git
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ * disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "archive.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <zdict.h>
+#include <zstd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "parse.hpp"
+#include "util.hpp"
+
+// decompression speed doesn't depend on the level, so we can afford a slow one at pack time
+constexpr int PACK_LEVEL = 19;
+
+struct PackedPage
+{
+    std::string name;  // "language/platform/command"
+    size_t      blob;
+    bool        resolved;
+
+    bool operator<(const PackedPage& other) const
+    { return this->name < other.name; }
+};
+
+// splitmix64 finalizer, spreads a displaced hash over the index slots
+static inline uint64_t mix_hash(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xbf58476d1ce4e5b9ull;
+    x ^= x >> 27;
+    x *= 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+static inline uint32_t index_bucket(const uint64_t h, const uint32_t bucket_count)
+{ return (h >> 32) % bucket_count; }
+
+static inline uint32_t index_slot(const uint64_t h, const uint32_t displacement, const uint32_t slot_count)
+{ return mix_hash(h ^ (displacement * 0x9e3779b97f4a7c15ull)) % slot_count; }
+
+PageArchive::~PageArchive()
+{ this->close(); }
+
+void PageArchive::close()
+{
+    ZSTD_freeDDict(this->ddict);
+    this->ddict = nullptr;
+
+    this->file.close();
+}
+
+bool PageArchive::open(const std::string_view path)
+{
+    this->close();
+
+    if (!this->file.open(path, sizeof(ArchiveHeader)))
+        return false;
+
+    const ArchiveHeader* hdr = this->header();
+    if (!this->file.has_header(ARCHIVE_MAGIC, ARCHIVE_VERSION) ||
+        hdr->file_size != this->file.size() || (hdr->entry_count > 0 && hdr->bucket_count == 0) ||
+        hdr->entries_off % alignof(ArchiveEntry) != 0 || hdr->index_off % alignof(uint32_t) != 0 ||
+        hdr->blobs_off < sizeof(ArchiveHeader) || hdr->blobs_off > hdr->dict_off ||
+        hdr->dict_off + hdr->dict_size > hdr->entries_off ||
+        hdr->entries_off + hdr->entry_count * sizeof(ArchiveEntry) > hdr->index_off ||
+        hdr->index_off + (hdr->bucket_count + uint64_t(hdr->entry_count)) * sizeof(uint32_t) > hdr->names_off ||
+        hdr->names_off > this->file.size())
+    {
+        warn("page archive {} is corrupted or outdated, ignoring it", path);
+        this->close();
+        return false;
+    }
+
+    if (hdr->dict_size > 0)
+    {
+        this->ddict = ZSTD_createDDict(this->file.data() + hdr->dict_off, hdr->dict_size);
+        if (!this->ddict)
+        {
+            warn("failed to load the zstd dictionary of page archive {}, ignoring it", path);
+            this->close();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+size_t PageArchive::size() const
+{ return this->file.data() ? this->header()->entry_count : 0; }
+
+std::string_view PageArchive::name(const size_t i) const
+{
+    const ArchiveEntry& entry = this->entries()[i];
+    const uint64_t      off   = this->header()->names_off + entry.name_off;
+    if (off + entry.name_len > this->file.size())
+        return {};
+
+    return { this->file.data() + off, entry.name_len };
+}
+
+std::string_view PageArchive::blob(const size_t i) const
+{
+    const ArchiveEntry& entry = this->entries()[i];
+    const uint64_t      off   = this->header()->blobs_off + entry.blob_off;
+    if (off + entry.blob_len > this->header()->dict_off)
+        return {};
+
+    return { this->file.data() + off, entry.blob_len };
+}
+
+std::string_view PageArchive::stored(const size_t i, std::string& buf) const
+{
+    const ArchiveEntry&    entry = this->entries()[i];
+    const std::string_view blob  = this->blob(i);
+    if (!(entry.flags & ENTRY_COMPRESSED))
+        return blob;
+
+    // one context per thread, reused by every page so decompressing doesn't allocate
+    static thread_local std::unique_ptr<ZSTD_DCtx, size_t (*)(ZSTD_DCtx*)> dctx(ZSTD_createDCtx(), ZSTD_freeDCtx);
+
+    buf.resize(entry.page_len);
+    const size_t ret =
+        this->ddict
+            ? ZSTD_decompress_usingDDict(dctx.get(), buf.data(), buf.size(), blob.data(), blob.size(), this->ddict)
+            : ZSTD_decompressDCtx(dctx.get(), buf.data(), buf.size(), blob.data(), blob.size());
+
+    if (ZSTD_isError(ret) || ret != entry.page_len)
+    {
+        error("failed to decompress page {}: {}", this->name(i), ZSTD_getErrorName(ret));
+        return {};
+    }
+
+    return buf;
+}
+
+std::string_view PageArchive::page(const size_t i, std::string& buf) const
+{
+    CompiledPage page;
+    return this->compiled(i, buf, page) ? page.markdown : std::string_view();
+}
+
+bool PageArchive::compiled(const size_t i, std::string& buf, CompiledPage& page) const
+{
+    const std::string_view data = this->stored(i, buf);
+    if (data.empty())
+        return false;
+
+    if (!read_compiled_page(data, page))
+    {
+        error("page {} is corrupted", this->name(i));
+        return false;
+    }
+
+    return true;
+}
+
+std::string_view PageArchive::find(const std::string_view language, const std::string_view platform,
+                                   const std::string_view command, std::string& buf) const
+{
+    const size_t i = this->lookup(language, platform, command);
+    return i == npos ? std::string_view() : this->page(i, buf);
+}
+
+size_t PageArchive::lookup(const std::string_view language, const std::string_view platform,
+                           const std::string_view command) const
+{
+    if (this->size() == 0)
+        return npos;
+
+    char         key[256];
+    const size_t len = language.size() + platform.size() + command.size() + 2;
+    if (len > sizeof(key))
+        return npos;
+
+    char* p = key;
+    std::memcpy(p, language.data(), language.size());
+    p += language.size();
+    *p++ = '/';
+    std::memcpy(p, platform.data(), platform.size());
+    p += platform.size();
+    *p++ = '/';
+    std::memcpy(p, command.data(), command.size());
+
+    const ArchiveHeader* hdr = this->header();
+    const uint64_t       h   = hash_bytes(key, len, hdr->hash_seed);
+    const uint32_t       i =
+        this->slots()[index_slot(h, this->displacements()[index_bucket(h, hdr->bucket_count)], hdr->entry_count)];
+
+    if (i >= hdr->entry_count || this->entries()[i].fingerprint != (h >> 32) ||
+        this->name(i) != std::string_view(key, len))
+        return npos;
+
+    return i;
+}
+
+/* Build the minimal perfect hash over the sorted page names (CHD algorithm)
+ * Keys are spread into buckets of ~4 keys, then the biggest buckets first look for a displacement
+ * which sends all of their keys into free slots. If two keys can't be told apart, retry with another seed.
+ */
+static void build_index(const std::vector<PackedPage>& pages, ArchiveHeader& hdr,
+                        std::vector<ArchiveEntry>& entries, std::vector<uint32_t>& displacements,
+                        std::vector<uint32_t>& slots)
+{
+    const uint32_t n = pages.size();
+    hdr.bucket_count = std::max<uint32_t>(1, (n + 3) / 4);
+    if (n == 0)
+    {
+        displacements.assign(hdr.bucket_count, 0);
+        return;
+    }
+
+    const uint64_t max_displacement = std::max<uint64_t>(1 << 16, uint64_t(n) * 32);
+    std::vector<uint64_t> hashes(n);
+    std::vector<std::vector<uint32_t>> buckets;
+    std::vector<uint32_t> order, positions;
+    std::vector<bool>     taken;
+
+    for (hdr.hash_seed = 0;; ++hdr.hash_seed)
+    {
+        buckets.assign(hdr.bucket_count, {});
+        for (uint32_t i = 0; i < n; ++i)
+        {
+            hashes[i] = hash_bytes(pages[i].name.data(), pages[i].name.size(), hdr.hash_seed);
+            buckets[index_bucket(hashes[i], hdr.bucket_count)].push_back(i);
+        }
+
+        order.resize(hdr.bucket_count);
+        for (uint32_t b = 0; b < hdr.bucket_count; ++b)
+            order[b] = b;
+        std::stable_sort(order.begin(), order.end(),
+                         [&](const uint32_t a, const uint32_t b) { return buckets[a].size() > buckets[b].size(); });
+
+        displacements.assign(hdr.bucket_count, 0);
+        slots.assign(n, UINT32_MAX);
+        taken.assign(n, false);
+
+        bool ok = true;
+        for (const uint32_t b : order)
+        {
+            const std::vector<uint32_t>& keys = buckets[b];
+            if (keys.empty())
+                break;
+
+            uint64_t d = 0;
+            for (; d < max_displacement; ++d)
+            {
+                positions.clear();
+                for (const uint32_t k : keys)
+                {
+                    const uint32_t pos = index_slot(hashes[k], d, n);
+                    if (taken[pos] || std::find(positions.begin(), positions.end(), pos) != positions.end())
+                        break;
+                    positions.push_back(pos);
+                }
+
+                if (positions.size() == keys.size())
+                    break;
+            }
+
+            if (d == max_displacement)
+            {
+                ok = false;
+                break;
+            }
+
+            displacements[b] = d;
+            for (size_t j = 0; j < keys.size(); ++j)
+            {
+                taken[positions[j]] = true;
+                slots[positions[j]] = keys[j];
+            }
+        }
+
+        if (ok)
+            break;
+
+        debug("page index: seed {} failed, retrying", hdr.hash_seed);
+    }
+
+    for (uint32_t i = 0; i < n; ++i)
+        entries[i].fingerprint = hashes[i] >> 32;
+}
+
+/* Train the zstd dictionary shared by every page
+ * @param samples All the pages concatenated
+ * @param sample_sizes Size of each page in samples
+ * @return the dictionary, or an empty string if the corpus is too small to train one
+ */
+static std::string train_dictionary(const std::string& samples, const std::vector<size_t>& sample_sizes)
+{
+    // ~1% of the corpus is usually the sweet spot, capped to the zstd default dictionary size
+    std::string  dict(std::clamp<size_t>(samples.size() / 100, 4096, 112640), '\0');
+    const size_t ret =
+        ZDICT_trainFromBuffer(dict.data(), dict.size(), samples.data(), sample_sizes.data(), sample_sizes.size());
+
+    if (ZDICT_isError(ret))
+    {
+        debug("not using a zstd dictionary: {}", ZDICT_getErrorName(ret));
+        return {};
+    }
+
+    dict.resize(ret);
+    return dict;
+}
+
+ArchiveWriter::ArchiveWriter(const std::string_view path)
+    : path(path), tmp_path(fmt::format("{}.tmp.{}", path, getpid()))
+{
+    std::filesystem::create_directories(std::filesystem::path(this->path).parent_path());
+    this->f.open(this->tmp_path, std::ios::binary | std::ios::trunc);
+    if (!this->f.is_open())
+        die("failed to create {}", this->tmp_path);
+    this->readback = ::open(this->tmp_path.c_str(), O_RDONLY | O_CLOEXEC);
+
+    // the header gets written once everything else is
+    const ArchiveHeader hdr{};
+    this->f.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+}
+
+ArchiveWriter::~ArchiveWriter()
+{
+    ZSTD_freeCCtx(this->cctx);
+    ZSTD_freeCDict(this->cdict);
+    ZSTD_freeDCtx(this->dctx);
+    ZSTD_freeDDict(this->ddict);
+    if (this->readback >= 0)
+        ::close(this->readback);
+
+    if (!this->finished)
+    {
+        this->f.close();
+        std::error_code ec;
+        std::filesystem::remove(this->tmp_path, ec);
+    }
+}
+
+void ArchiveWriter::set_dictionary(const std::string_view dict)
+{
+    this->dict = dict;
+    this->start_compressing();
+}
+
+void ArchiveWriter::start_compressing()
+{
+    this->cctx = ZSTD_createCCtx();
+    if (!this->dict.empty())
+        this->cdict = ZSTD_createCDict(this->dict.data(), this->dict.size(), PACK_LEVEL);
+
+    ZSTD_CCtx_setParameter(this->cctx, ZSTD_c_compressionLevel, PACK_LEVEL);
+    ZSTD_CCtx_setParameter(this->cctx, ZSTD_c_checksumFlag, 0);
+    ZSTD_CCtx_setParameter(this->cctx, ZSTD_c_dictIDFlag, 0);
+    if (this->cdict)
+        ZSTD_CCtx_refCDict(this->cctx, this->cdict);
+
+    this->dict_ready = true;
+}
+
+void ArchiveWriter::write_blob(Blob& blob, const std::string_view content)
+{
+    this->compressed.resize(ZSTD_compressBound(content.size()));
+    const size_t ret =
+        ZSTD_compress2(this->cctx, this->compressed.data(), this->compressed.size(), content.data(), content.size());
+
+    // keep the page as it is if compressing it doesn't save anything
+    std::string_view data = content;
+    blob.compressed       = !ZSTD_isError(ret) && ret < content.size();
+    if (blob.compressed)
+        data = std::string_view(this->compressed.data(), ret);
+
+    blob.blob_off = this->blobs_size;
+    blob.blob_len = data.size();
+    this->f.write(data.data(), data.size());
+    this->blobs_size += data.size();
+}
+
+bool ArchiveWriter::holds(const Blob& blob, const std::string_view content)
+{
+    if (blob.page_len != content.size())
+        return false;
+
+    // still held back, blob_off is where it is in the samples
+    if (!this->dict_ready)
+        return std::string_view(this->samples).substr(blob.blob_off, blob.page_len) == content;
+
+    // read it back from what was written so far
+    std::string data(blob.blob_len, '\0');
+    this->f.flush();
+    if (this->readback < 0 ||
+        pread(this->readback, data.data(), data.size(), sizeof(ArchiveHeader) + blob.blob_off) != ssize_t(data.size()))
+        return false;
+    if (!blob.compressed)
+        return data == content;
+
+    if (!this->dctx)
+        this->dctx = ZSTD_createDCtx();
+    if (!this->ddict && !this->dict.empty())
+        this->ddict = ZSTD_createDDict(this->dict.data(), this->dict.size());
+
+    std::string  page(blob.page_len, '\0');
+    const size_t ret =
+        this->ddict
+            ? ZSTD_decompress_usingDDict(this->dctx, page.data(), page.size(), data.data(), data.size(), this->ddict)
+            : ZSTD_decompressDCtx(this->dctx, page.data(), page.size(), data.data(), data.size());
+    return !ZSTD_isError(ret) && ret == page.size() && page == content;
+}
+
+size_t ArchiveWriter::store(const std::string_view content, const uint64_t hash)
+{
+    // two pages sharing their hash aren't trusted to be the same, a collision gets a blob of its own
+    const auto& it = this->blobs_by_hash.find(hash);
+    if (it != this->blobs_by_hash.end() && this->holds(this->blobs[it->second], content))
+        return it->second;
+
+    const size_t i = this->blobs.size();
+    this->blobs.push_back({ hash, this->samples.size(), 0, static_cast<uint32_t>(content.size()), false });
+    this->blobs_by_hash.emplace(hash, i);
+
+    if (this->dict_ready)
+    {
+        this->write_blob(this->blobs[i], content);
+        return i;
+    }
+
+    // hold the first pages back until there are enough of them to train the dictionary
+    this->samples += content;
+    this->sample_sizes.push_back(content.size());
+    this->pending.push_back(i);
+    if (this->samples.size() >= ARCHIVE_SAMPLE_BUDGET)
+        this->flush_pending();
+
+    return i;
+}
+
+void ArchiveWriter::flush_pending()
+{
+    this->dict = train_dictionary(this->samples, this->sample_sizes);
+    this->start_compressing();
+
+    size_t off = 0;
+    for (size_t j = 0; j < this->pending.size(); ++j)
+    {
+        this->write_blob(this->blobs[this->pending[j]],
+                         std::string_view(this->samples).substr(off, this->sample_sizes[j]));
+        off += this->sample_sizes[j];
+    }
+
+    this->samples.clear();
+    this->samples.shrink_to_fit();
+    this->sample_sizes.clear();
+    this->pending.clear();
+}
+
+void ArchiveWriter::add(const std::string_view language, const std::string_view platform,
+                        const std::string_view command, const std::string_view content)
+{
+    compile_page(content, this->compiled);
+    const size_t blob = this->store(this->compiled, hash_bytes(content.data(), content.size()));
+    this->pages[fmt::format("{}/{}/{}", language, platform, command)] = blob;
+}
+
+void ArchiveWriter::copy(const PageArchive& from, const size_t i)
+{
+    const ArchiveEntry& entry = from.entries()[i];
+    const auto&         it    = this->blobs_by_hash.find(entry.content_hash);
+    std::string         buf;
+    if (it != this->blobs_by_hash.end() && this->holds(this->blobs[it->second], from.stored(i, buf)))
+    {
+        this->pages[std::string(from.name(i))] = it->second;
+        return;
+    }
+
+    // same dictionary, the blob can be copied as it is
+    if (this->dict_ready && (!(entry.flags & ENTRY_COMPRESSED) || from.dictionary() == this->dict))
+    {
+        const std::string_view data = from.blob(i);
+        const size_t           blob = this->blobs.size();
+        this->blobs.push_back({ entry.content_hash, this->blobs_size, static_cast<uint32_t>(data.size()),
+                                entry.page_len, (entry.flags & ENTRY_COMPRESSED) != 0 });
+        this->blobs_by_hash.emplace(entry.content_hash, blob);
+        this->f.write(data.data(), data.size());
+        this->blobs_size += data.size();
+        this->pages[std::string(from.name(i))] = blob;
+        return;
+    }
+
+    const std::string_view content = from.stored(i, buf);
+    this->pages[std::string(from.name(i))] = this->store(content, entry.content_hash);
+}
+
+size_t ArchiveWriter::finish()
+{
+    if (!this->dict_ready)
+        this->flush_pending();
+
+    // language -> command -> platform -> blob
+    std::map<std::string, std::map<std::string, std::map<std::string, size_t>>> languages;
+    std::set<std::string>                                                     platforms{ get_platform(), "common" };
+    for (const auto& [name, blob] : this->pages)
+    {
+        const size_t first = name.find('/'), second = name.find('/', first + 1);
+        const std::string& platform = name.substr(first + 1, second - first - 1);
+        languages[name.substr(0, first)][name.substr(second + 1)][platform] = blob;
+        platforms.insert(platform);
+    }
+
+    // resolve the page of every command for every platform: platform -> common -> other platforms
+    std::vector<PackedPage> pages;
+    for (const auto& [language, commands] : languages)
+    {
+        for (const auto& [command, found] : commands)
+        {
+            for (const std::string& platform : platforms)
+            {
+                auto it = found.find(platform);
+                bool resolved = it == found.end();
+                if (resolved && (it = found.find("common")) == found.end())
+                    it = found.begin();
+
+                pages.push_back({ fmt::format("{}/{}/{}", language, platform, command), it->second, resolved });
+            }
+        }
+    }
+
+    std::sort(pages.begin(), pages.end());
+
+    ArchiveHeader hdr{};
+    std::memcpy(hdr.magic, ARCHIVE_MAGIC, sizeof(ARCHIVE_MAGIC));
+    hdr.version     = ARCHIVE_VERSION;
+    hdr.entry_count = pages.size();
+
+    std::vector<ArchiveEntry> entries(pages.size());
+    std::string               names;
+    for (size_t i = 0; i < pages.size(); ++i)
+    {
+        const Blob& blob        = this->blobs[pages[i].blob];
+        entries[i].name_off     = names.size();
+        entries[i].name_len     = pages[i].name.size();
+        entries[i].flags        = (pages[i].resolved ? ENTRY_RESOLVED : 0) | (blob.compressed ? ENTRY_COMPRESSED : 0);
+        entries[i].page_len     = blob.page_len;
+        entries[i].blob_off     = blob.blob_off;
+        entries[i].blob_len     = blob.blob_len;
+        entries[i].content_hash = blob.hash;
+        names += pages[i].name;
+    }
+
+    std::vector<uint32_t> displacements, slots;
+    build_index(pages, hdr, entries, displacements, slots);
+
+    hdr.blobs_off   = sizeof(ArchiveHeader);
+    hdr.dict_off    = hdr.blobs_off + this->blobs_size;
+    hdr.dict_size   = this->dict.size();
+    hdr.entries_off = (hdr.dict_off + hdr.dict_size + alignof(ArchiveEntry) - 1) & ~(alignof(ArchiveEntry) - 1);
+    hdr.index_off   = hdr.entries_off + entries.size() * sizeof(ArchiveEntry);
+    hdr.names_off   = hdr.index_off + (displacements.size() + slots.size()) * sizeof(uint32_t);
+    hdr.file_size   = hdr.names_off + names.size();
+
+    const char padding[alignof(ArchiveEntry)]{};
+    this->f.write(this->dict.data(), this->dict.size());
+    this->f.write(padding, hdr.entries_off - hdr.dict_off - hdr.dict_size);
+    this->f.write(reinterpret_cast<const char*>(entries.data()), entries.size() * sizeof(ArchiveEntry));
+    this->f.write(reinterpret_cast<const char*>(displacements.data()), displacements.size() * sizeof(uint32_t));
+    this->f.write(reinterpret_cast<const char*>(slots.data()), slots.size() * sizeof(uint32_t));
+    this->f.write(names.data(), names.size());
+    this->f.seekp(0);
+    this->f.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+    this->f.close();
+    if (!this->f)
+        die("failed to write {}", this->tmp_path);
+
+    std::filesystem::rename(this->tmp_path, this->path);
+    this->finished = true;
+    return this->pages.size();
+}
+
+size_t pack_pages(const std::string_view cache_dir, const std::string_view archive_path)
+{
+    namespace fs = std::filesystem;
+
+    ArchiveWriter   writer(archive_path);
+    std::string     content;
+    std::error_code ec;
+    for (const fs::directory_entry& pages_dir : fs::directory_iterator(cache_dir, ec))
+    {
+        // "pages" is english, translations are in "pages.<language>"
+        const std::string& dirname = pages_dir.path().filename().string();
+        if (!pages_dir.is_directory() || (dirname != "pages" && !hasStart(dirname, "pages.")))
+            continue;
+
+        const std::string& language = dirname == "pages" ? "en" : dirname.substr("pages."_len);
+        for (const fs::directory_entry& platform : fs::directory_iterator(pages_dir.path(), ec))
+        {
+            if (!platform.is_directory())
+                continue;
+
+            for (const fs::directory_entry& file : fs::directory_iterator(platform.path(), ec))
+            {
+                if (!file.is_regular_file() || file.path().extension() != ".md")
+                    continue;
+
+                if (!read_file(file.path().string(), content))
+                    die("failed to read {}", file.path().string());
+
+                writer.add(language, platform.path().filename().string(), file.path().stem().string(), content);
+            }
+        }
+    }
+
+    if (ec)
+        die("failed to read cache directory {}: {}", cache_dir, ec.message());
+
+    return writer.finish();
+}
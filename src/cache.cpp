@@ -0,0 +1,202 @@
+/*
+ * Copyright 2024 Toni500git
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ * disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "cache.hpp"
+
+#include <fcntl.h>
+#include <limits.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <charconv>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <string_view>
+
+#include "util.hpp"
+
+/* Get the generation number out of a generation directory name
+ * @param name The directory name (e.g "gen-42")
+ * @param gen Where to store the generation number
+ * @return false if name is not a generation directory
+ */
+static bool parse_generation(std::string_view name, uint64_t& gen)
+{
+    if (!hasStart(name, "gen-"))
+        return false;
+
+    name.remove_prefix("gen-"_len);
+    const auto& [ptr, ec] = std::from_chars(name.data(), name.data() + name.size(), gen);
+    return ec == std::errc() && ptr == name.data() + name.size();
+}
+
+CacheGeneration::~CacheGeneration()
+{
+    if (this->dirfd >= 0)
+        close(this->dirfd);
+}
+
+bool CacheGeneration::pin()
+{
+    const std::string& cache_dir = getCacheDir();
+
+    // a writer may garbage-collect the generation we resolved before we manage to pin it,
+    // in that case current already points to a newer one, so just resolve it again
+    for (int tries = 0; tries < 8; ++tries)
+    {
+        char          target[PATH_MAX];
+        const ssize_t len = readlink((cache_dir + "/current").c_str(), target, sizeof(target) - 1);
+        if (len < 0)
+            return false;
+
+        target[len] = '\0';
+        uint64_t gen;
+        if (!parse_generation(target, gen))
+        {
+            warn("{}/current points to {}, which is not a cache generation", cache_dir, target);
+            return false;
+        }
+
+        const std::string& dir = fmt::format("{}/{}", cache_dir, target);
+        const int          fd  = open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0)
+            continue;
+
+        // st_nlink is 0 if it got removed between open() and flock()
+        struct stat st;
+        if (flock(fd, LOCK_SH | LOCK_NB) < 0 || fstat(fd, &st) < 0 || st.st_nlink == 0)
+        {
+            close(fd);
+            continue;
+        }
+
+        if (this->dirfd >= 0)
+            close(this->dirfd);
+
+        this->dirfd = fd;
+        this->gen   = gen;
+        this->dir   = dir;
+        debug("pinned cache generation {}", dir);
+        return true;
+    }
+
+    return false;
+}
+
+GenerationBuilder::GenerationBuilder()
+{
+    namespace fs = std::filesystem;
+
+    const std::string& cache_dir = getCacheDir();
+    fs::create_directories(cache_dir);
+
+    const std::string& lock_path = cache_dir + "/.lock";
+    this->lockfd                 = open(lock_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (this->lockfd < 0)
+        die("failed to open {}: {}", lock_path, strerror(errno));
+
+    if (flock(this->lockfd, LOCK_EX | LOCK_NB) < 0)
+    {
+        info("waiting for another wrapup to finish updating the cache");
+        if (flock(this->lockfd, LOCK_EX) < 0)
+            die("failed to lock {}: {}", lock_path, strerror(errno));
+    }
+
+    std::error_code ec;
+    for (const fs::directory_entry& entry : fs::directory_iterator(cache_dir, ec))
+    {
+        uint64_t gen;
+        if (parse_generation(entry.path().filename().string(), gen))
+            this->gen = std::max(this->gen, gen);
+    }
+    ++this->gen;
+
+    // a leftover from a writer that crashed, we hold the lock so nobody else is using it
+    this->tmp_dir = fmt::format("{}/gen-{}.tmp", cache_dir, this->gen);
+    fs::remove_all(this->tmp_dir, ec);
+    if (!fs::create_directory(this->tmp_dir, ec))
+        die("failed to create {}: {}", this->tmp_dir, ec.message());
+}
+
+GenerationBuilder::~GenerationBuilder()
+{
+    if (!this->committed)
+    {
+        std::error_code ec;
+        std::filesystem::remove_all(this->tmp_dir, ec);
+    }
+
+    close(this->lockfd);
+}
+
+void GenerationBuilder::commit()
+{
+    namespace fs = std::filesystem;
+
+    const std::string& cache_dir = getCacheDir();
+    const std::string& name      = fmt::format("gen-{}", this->gen);
+    const std::string& gen_dir   = fmt::format("{}/{}", cache_dir, name);
+    const std::string& tmp_link  = fmt::format("{}/current.tmp.{}", cache_dir, getpid());
+
+    if (rename(this->tmp_dir.c_str(), gen_dir.c_str()) < 0)
+        die("failed to rename {} to {}: {}", this->tmp_dir, gen_dir, strerror(errno));
+
+    this->tmp_dir   = gen_dir;
+    this->committed = true;
+
+    // rename() over the old symlink is atomic, readers either get the old generation or the new one
+    unlink(tmp_link.c_str());
+    if (symlink(name.c_str(), tmp_link.c_str()) < 0 || rename(tmp_link.c_str(), (cache_dir + "/current").c_str()) < 0)
+        die("failed to publish cache generation {}: {}", gen_dir, strerror(errno));
+
+    // garbage-collect the old generations nobody pinned, trying to take the lock tells us if somebody did
+    std::error_code ec;
+    for (const fs::directory_entry& entry : fs::directory_iterator(cache_dir, ec))
+    {
+        std::string filename = entry.path().filename().string();
+        if (hasEnding(filename, ".tmp"))
+            filename.erase(filename.size() - ".tmp"_len);
+
+        uint64_t gen;
+        if (!parse_generation(filename, gen) || gen == this->gen)
+            continue;
+
+        const int fd = open(entry.path().c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (fd < 0)
+            continue;
+
+        if (flock(fd, LOCK_EX | LOCK_NB) == 0)
+        {
+            debug("removing old cache generation {}", entry.path().string());
+            std::error_code remove_ec;
+            fs::remove_all(entry.path(), remove_ec);
+        }
+
+        close(fd);
+    }
+}
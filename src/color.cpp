@@ -0,0 +1,88 @@
+/*
+ * Copyright 2024 Toni500git
+ * 
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ * disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "color.hpp"
+
+#include <cstdlib>
+#include <string>
+#include <string_view>
+
+#include "util.hpp"
+
+ColorDepth detect_color_depth()
+{
+    const char* colorterm = std::getenv("COLORTERM");
+    if (colorterm && (std::string_view(colorterm) == "truecolor" || std::string_view(colorterm) == "24bit"))
+        return ColorDepth::TRUECOLOR;
+
+    const char* term = std::getenv("TERM");
+    if (term)
+    {
+        const std::string_view name = term;
+        if (hasEnding(name, "-direct"))
+            return ColorDepth::TRUECOLOR;
+        if (name.find("256color") != name.npos)
+            return ColorDepth::ANSI256;
+    }
+
+    return ColorDepth::ANSI16;
+}
+
+bool color_to_sgr(const std::string_view spec, const ColorDepth depth, std::string& out)
+{
+    std::string params;
+    for (const std::string& word : split(spec, ' '))
+    {
+        if (!params.empty() && !word.empty())
+            params += ';';
+
+        uint32_t rgb;
+        if (word.empty())
+            continue;
+        else if (word == "bold")
+            params += '1';
+        else if (word == "italic")
+            params += '3';
+        else if (word == "underline")
+            params += '4';
+        else if (!parse_hex_color(word, rgb))
+            return false;
+        else if (depth == ColorDepth::TRUECOLOR)
+            params += fmt::format("38;2;{};{};{}", red(rgb), green(rgb), blue(rgb));
+        else if (depth == ColorDepth::ANSI256)
+            params += fmt::format("38;5;{}", rgb_to_ansi256(rgb));
+        else
+        {
+            const uint8_t ansi = ANSI256_TO_16[rgb_to_ansi256(rgb)];
+            params += std::to_string(ansi < 8 ? 30 + ansi : 90 + ansi - 8);
+        }
+    }
+
+    if (params.empty())
+        return false;
+
+    out = "\033[" + params + 'm';
+    return true;
+}
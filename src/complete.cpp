@@ -0,0 +1,223 @@
+/*
+ * Copyright 2024 Toni500git
+ * 
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ * disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "complete.hpp"
+
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "archive.hpp"
+#include "cache.hpp"
+#include "output.hpp"
+#include "parse.hpp"
+#include "util.hpp"
+
+CompleteIndex::~CompleteIndex()
+{ this->close(); }
+
+void CompleteIndex::close()
+{ this->file.close(); }
+
+bool CompleteIndex::open(const std::string_view path)
+{
+    this->close();
+
+    if (!this->file.open(path, sizeof(CompleteHeader)))
+        return false;
+
+    const CompleteHeader* hdr = this->header();
+    if (!this->file.has_header(COMPLETE_MAGIC, COMPLETE_VERSION) ||
+        hdr->file_size != this->file.size() ||
+        hdr->blocks_off != sizeof(CompleteHeader) + uint64_t(hdr->block_count) * sizeof(uint32_t) ||
+        hdr->blocks_off > this->file.size() ||
+        hdr->block_count != (hdr->name_count + COMPLETE_BLOCK_SIZE - 1) / COMPLETE_BLOCK_SIZE)
+    {
+        warn("completion index {} is corrupted or outdated, ignoring it", path);
+        this->close();
+        return false;
+    }
+
+    return true;
+}
+
+std::string_view CompleteIndex::block_head(const size_t block) const
+{
+    const std::string_view blocks(this->file.data() + this->header()->blocks_off,
+                                  this->file.size() - this->header()->blocks_off);
+    size_t   i = this->block_offsets()[block];
+    uint32_t len;
+    if (!read_varint(blocks, i, len) || i + len > blocks.size())
+        return {};
+
+    return blocks.substr(i, len);
+}
+
+bool CompleteIndex::complete(const std::string_view language, const std::string_view prefix,
+                             std::vector<std::string>& commands) const
+{
+    if (!this->file.data() || this->header()->name_count == 0)
+        return true;
+
+    const CompleteHeader* hdr = this->header();
+
+    const std::string& key = fmt::format("{}/{}", language, prefix);
+
+    // the last block starting before key, the names matching it may begin there
+    size_t lo = 0, hi = hdr->block_count;
+    while (lo < hi)
+    {
+        const size_t mid = lo + (hi - lo) / 2;
+        if (this->block_head(mid) <= key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    const std::string_view blocks(this->file.data() + hdr->blocks_off, this->file.size() - hdr->blocks_off);
+    std::string            name;
+    for (size_t block = lo > 0 ? lo - 1 : 0; block < hdr->block_count; ++block)
+    {
+        size_t       i     = this->block_offsets()[block];
+        const size_t count = std::min<size_t>(COMPLETE_BLOCK_SIZE, hdr->name_count - block * COMPLETE_BLOCK_SIZE);
+        for (size_t n = 0; n < count; ++n)
+        {
+            uint32_t shared = 0, len;
+            if ((n > 0 && !read_varint(blocks, i, shared)) || !read_varint(blocks, i, len) ||
+                shared > name.size() || i + len > blocks.size())
+            {
+                error("completion index is corrupted");
+                return false;
+            }
+
+            name.resize(shared);
+            name.append(blocks.data() + i, len);
+            i += len;
+
+            if (name < key)
+                continue;
+
+            // sorted, so the names having the prefix are all next to each other
+            if (name.compare(0, key.size(), key) != 0)
+                return true;
+
+            commands.push_back(name.substr(language.size() + 1));
+        }
+    }
+
+    return true;
+}
+
+size_t build_complete_index(const std::string_view generation_dir)
+{
+    const std::string& archive_path = fmt::format("{}/{}", generation_dir, ARCHIVE_NAME);
+    PageArchive        archive;
+    if (!archive.open(archive_path))
+        die("failed to open {}", archive_path);
+
+    // the archive has every command in every platform, so the current one also lists those from the others
+    const std::string&       platform = get_platform();
+    std::vector<std::string> names;
+    for (size_t i = 0; i < archive.size(); ++i)
+    {
+        const std::string_view name  = archive.name(i);
+        const size_t           first = name.find('/'), second = name.find('/', first + 1);
+        if (second != name.npos && name.substr(first + 1, second - first - 1) == platform)
+            names.push_back(fmt::format("{}/{}", name.substr(0, first), name.substr(second + 1)));
+    }
+    std::sort(names.begin(), names.end());
+
+    std::vector<uint32_t> offsets;
+    std::string           blocks;
+    for (size_t i = 0; i < names.size(); ++i)
+    {
+        size_t shared = 0;
+        if (i % COMPLETE_BLOCK_SIZE == 0)
+        {
+            offsets.push_back(blocks.size());
+        }
+        else
+        {
+            const std::string& prev = names[i - 1];
+            while (shared < prev.size() && shared < names[i].size() && prev[shared] == names[i][shared])
+                ++shared;
+            write_varint(blocks, shared);
+        }
+
+        write_varint(blocks, names[i].size() - shared);
+        blocks.append(names[i], shared);
+    }
+
+    CompleteHeader hdr{};
+    std::memcpy(hdr.magic, COMPLETE_MAGIC, sizeof(COMPLETE_MAGIC));
+    hdr.version     = COMPLETE_VERSION;
+    hdr.name_count  = names.size();
+    hdr.block_count = offsets.size();
+    hdr.blocks_off  = sizeof(CompleteHeader) + offsets.size() * sizeof(uint32_t);
+    hdr.file_size   = hdr.blocks_off + blocks.size();
+
+    const std::string& path = fmt::format("{}/{}", generation_dir, COMPLETE_INDEX_NAME);
+    const std::string& tmp  = temp_path(path);
+    std::ofstream      f(tmp, std::ios::binary | std::ios::trunc);
+    f.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+    f.write(reinterpret_cast<const char*>(offsets.data()), offsets.size() * sizeof(uint32_t));
+    f.write(blocks.data(), blocks.size());
+    f.close();
+    if (!f)
+        die("failed to write {}", tmp);
+
+    std::filesystem::rename(tmp, path);
+    return names.size();
+}
+
+bool complete_pages(const std::string_view generation_dir, const std::string_view prefix)
+{
+    CompleteIndex index;
+    if (generation_dir.empty() || !index.open(fmt::format("{}/{}", generation_dir, COMPLETE_INDEX_NAME)))
+        return false;
+
+    std::vector<std::string> commands;
+    for (const std::string& language : get_languages())
+        if (!index.complete(language, prefix, commands))
+            return false;
+
+    std::sort(commands.begin(), commands.end());
+    commands.erase(std::unique(commands.begin(), commands.end()), commands.end());
+
+    std::string list;
+    for (const std::string& command : commands)
+        list += fmt::format("{}\n", command);
+
+    FdSink out(STDOUT_FILENO);
+    out.write(std::move(list));
+    out.finish();
+    return true;
+}
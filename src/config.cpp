@@ -62,16 +62,67 @@ void Config::loadConfigFile(const std::string_view filename)
         exit(-1);
     }
 
-    this->clr_title = getThemeValue("colors.title", "\033[1m");
-    this->clr_description = getThemeValue("colors.description", "\033[34m");
-    this->clr_example_text = getThemeValue("colors.example-text", "\033[36m");
-    this->clr_example_code = getThemeValue("colors.example-code", "\033[33m");
+    const std::string& depth = getValue<std::string>("colors.depth", "auto");
+    if (depth == "truecolor")
+        this->color_depth = ColorDepth::TRUECOLOR;
+    else if (depth == "256")
+        this->color_depth = ColorDepth::ANSI256;
+    else if (depth == "16")
+        this->color_depth = ColorDepth::ANSI16;
+    else
+    {
+        if (depth != "auto")
+            warn("Unknown colors.depth \"{}\", detecting it from the terminal", depth);
+        this->color_depth = detect_color_depth();
+    }
+
+    this->clr_title = getThemeValue("colors.title", DEFAULT_CLR_TITLE);
+    this->clr_description = getThemeValue("colors.description", DEFAULT_CLR_DESCRIPTION);
+    this->clr_example_text = getThemeValue("colors.example-text", DEFAULT_CLR_EXAMPLE_TEXT);
+    this->clr_example_code = getThemeValue("colors.example-code", DEFAULT_CLR_EXAMPLE_CODE);
+
+    this->theme.title           = "  " + this->clr_title;
+    this->theme.description     = "  " + this->clr_description;
+    this->theme.example         = "  -" + this->clr_example_text + " ";
+    this->theme.code            = "  \t" + this->clr_example_code;
+    this->theme.placeholder_end = NOCOLOR + this->clr_example_code;
+
+    this->default_theme = this->clr_title == DEFAULT_CLR_TITLE && this->clr_description == DEFAULT_CLR_DESCRIPTION &&
+                          this->clr_example_text == DEFAULT_CLR_EXAMPLE_TEXT &&
+                          this->clr_example_code == DEFAULT_CLR_EXAMPLE_CODE;
+
+    this->update_index_url = getValue<std::string>(
+        "update.index-url", "https://api.github.com/repos/tldr-pages/tldr/git/trees/main?recursive=1");
+    this->update_pages_url =
+        getValue<std::string>("update.pages-url", "https://raw.githubusercontent.com/tldr-pages/tldr/refs/heads/main");
+    this->update_archive_url = getValue<std::string>(
+        "update.archive-url", "https://github.com/tldr-pages/tldr/releases/latest/download/tldr.zip");
+
+    this->pager = getValue<bool>("output.pager", false);
+
+    this->cache_rendered          = getValue<bool>("cache.rendered", false);
+    const int64_t max_size = getValue<int64_t>("cache.rendered-max-size", 4 * 1024 * 1024);
+    if (max_size < 0)
+        warn("cache.rendered-max-size can't be negative ({}), using the default size", max_size);
+    this->cache_rendered_max_size = max_size < 0 ? 4 * 1024 * 1024 : max_size;
 }
 
 // Config::getValue() but don't want to specify the template
+// colors written as "#rrggbb" get turned into the escape sequence for this->color_depth
 std::string Config::getThemeValue(const std::string_view value, const std::string_view fallback) const
 {
-    return this->tbl.at_path(value).value<std::string>().value_or(fallback.data());
+    const std::string& color = this->tbl.at_path(value).value<std::string>().value_or(fallback.data());
+    if (color.find('#') == color.npos)
+        return color;
+
+    std::string sgr;
+    if (!color_to_sgr(color, this->color_depth, sgr))
+    {
+        warn("Invalid color \"{}\" for {}, using the default one", color, value);
+        return fallback.data();
+    }
+
+    return sgr;
 }
 
 void Config::generateConfig(const std::string_view filename)
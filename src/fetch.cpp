@@ -0,0 +1,243 @@
+/*
+ * Copyright 2024 Toni500git
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ * disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "fetch.hpp"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "fmt/format.h"
+#include "util.hpp"
+
+#if ONLINE
+# include "cpr/cpr.h"
+
+struct CachedResponse
+{
+    std::string etag;
+    std::string last_modified;
+    std::string body;
+};
+
+static std::string cached_response_path(const std::string_view url)
+{ return fmt::format("{}/http/{:016x}", getCacheDir(), hash_bytes(url.data(), url.size())); }
+
+/* The copy is stored as "<url>\n<etag>\n<last-modified>\n<body>",
+ * the url being there to tell apart two urls which hash the same
+ */
+static bool read_cached_response(const std::string_view url, CachedResponse& cached)
+{
+    std::string buf;
+    if (!read_file(cached_response_path(url), buf))
+        return false;
+
+    size_t       begin = 0;
+    std::string* fields[] = { nullptr, &cached.etag, &cached.last_modified };
+    for (std::string* field : fields)
+    {
+        const size_t end = buf.find('\n', begin);
+        if (end == buf.npos)
+            return false;
+
+        const std::string_view value(buf.data() + begin, end - begin);
+        if (!field && value != url)
+            return false;
+        if (field)
+            field->assign(value);
+        begin = end + 1;
+    }
+
+    cached.body.assign(buf, begin, buf.npos);
+    return true;
+}
+
+static void write_cached_response(const std::string_view url, const CachedResponse& cached)
+{
+    const std::string& path = cached_response_path(url);
+    if (!replace_file(path, fmt::format("{}\n{}\n{}\n{}", url, cached.etag, cached.last_modified, cached.body)))
+    {
+        debug("failed to cache the response of {}", url);
+        return;
+    }
+
+    // the copies of urls which aren't fetched anymore (e.g the index url got changed in the config) go away
+    evict_least_recently_used(std::filesystem::path(path).parent_path().string(), HTTP_CACHE_MAX_SIZE);
+}
+
+bool fetch_url(const std::string_view url, std::string& out, long& status)
+{
+    CachedResponse cached;
+    const bool     has_cached = read_cached_response(url, cached);
+
+    cpr::Session session;
+    session.SetUrl(cpr::Url(std::string(url)));
+    if (has_cached)
+    {
+        cpr::Header header;
+        if (!cached.etag.empty())
+            header["If-None-Match"] = cached.etag;
+        if (!cached.last_modified.empty())
+            header["If-Modified-Since"] = cached.last_modified;
+        session.SetHeader(header);
+    }
+
+    cpr::Response r = session.Get();
+    status          = r.status_code;
+    if (r.status_code == 304 && has_cached)
+    {
+        debug("{} not modified, using the cached copy", url);
+        // it's used again, so it goes last in the eviction order
+        utimensat(AT_FDCWD, cached_response_path(url).c_str(), nullptr, 0);
+        out = std::move(cached.body);
+        return true;
+    }
+
+    if (r.status_code != 200)
+        return false;
+
+    const auto& etag          = r.header.find("ETag");
+    const auto& last_modified = r.header.find("Last-Modified");
+    // without validators there'd be no way to revalidate the copy, so don't bother keeping it
+    if (etag != r.header.end() || last_modified != r.header.end())
+    {
+        cached.etag          = etag != r.header.end() ? etag->second : "";
+        cached.last_modified = last_modified != r.header.end() ? last_modified->second : "";
+        cached.body          = r.text;
+        write_cached_response(url, cached);
+    }
+
+    out = std::move(r.text);
+    return true;
+}
+#else
+bool fetch_url(const std::string_view url, std::string& out, long& status)
+{
+    status = 0;
+    return false;
+}
+#endif
+
+struct Miss
+{
+    std::string url;
+    int64_t     expires;
+};
+
+static std::string misses_path()
+{ return getCacheDir() + "/misses"; }
+
+static int64_t now_seconds()
+{
+    return std::chrono::duration_cast<std::chrono::seconds>(std::chrono::system_clock::now().time_since_epoch())
+        .count();
+}
+
+// the misses which didn't expire yet, sorted by url
+static std::vector<Miss> read_misses()
+{
+    std::vector<Miss> misses;
+    std::string       buf;
+    if (!read_file(misses_path(), buf))
+        return misses;
+
+    const int64_t now = now_seconds();
+    for (const std::string& line : split(buf, '\n'))
+    {
+        const size_t space = line.find(' ');
+        if (space == line.npos)
+            continue;
+
+        const int64_t expires = std::strtoll(line.c_str(), nullptr, 10);
+        if (expires > now)
+            misses.push_back({ line.substr(space + 1), expires });
+    }
+
+    return misses;
+}
+
+static std::vector<Miss>::iterator find_miss(std::vector<Miss>& misses, const std::string_view url)
+{
+    return std::lower_bound(misses.begin(), misses.end(), url,
+                            [](const Miss& miss, const std::string_view key) { return miss.url < key; });
+}
+
+bool is_known_miss(const std::string_view url)
+{
+    std::vector<Miss> misses = read_misses();
+    const auto&       it     = find_miss(misses, url);
+    return it != misses.end() && it->url == url;
+}
+
+void remember_miss(const std::string_view url)
+{
+    // pages are looked up from several threads and processes, don't lose the miss of one to the rewrite of another.
+    // flock() locks conflict between open()s of the same process too, so the threads are covered as well
+    const std::string& lock_path = misses_path() + ".lock";
+    const int          lockfd    = open(lock_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (lockfd < 0 || flock(lockfd, LOCK_EX) < 0)
+    {
+        // it's only a cache, losing a miss costs a request
+        debug("failed to lock {}: {}", lock_path, std::strerror(errno));
+        if (lockfd >= 0)
+            close(lockfd);
+        return;
+    }
+
+    std::vector<Miss> misses  = read_misses();
+    const int64_t     expires = now_seconds() + MISS_TTL.count();
+    const auto&       it      = find_miss(misses, url);
+    if (it != misses.end() && it->url == url)
+        it->expires = expires;
+    else
+        misses.insert(it, { std::string(url), expires });
+
+    std::string text;
+    for (const Miss& miss : misses)
+        text += fmt::format("{} {}\n", miss.expires, miss.url);
+    replace_file(misses_path(), text);
+
+    // closing it releases the lock
+    close(lockfd);
+}
+
+void clear_misses()
+{
+    std::error_code ec;
+    std::filesystem::remove(misses_path(), ec);
+}
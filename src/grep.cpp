@@ -0,0 +1,251 @@
+/*
+ * Copyright 2024 Toni500git
+ * 
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ * disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "grep.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <condition_variable>
+#include <mutex>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "page.hpp"
+#include "parse.hpp"
+#include "util.hpp"
+
+// pages a thread takes at once, and whose matches are written together
+constexpr size_t GREP_CHUNK = 64;
+
+std::string required_literal(const std::string_view pattern)
+{
+    std::string best, run;
+    const auto& end_run = [&]() {
+        if (run.size() > best.size())
+            best = run;
+        run.clear();
+    };
+
+    for (size_t i = 0; i < pattern.size(); ++i)
+    {
+        char c = pattern[i];
+        switch (c)
+        {
+            // any of the alternatives can match, none of them is required
+            case '|': return {};
+
+            // a quantifier makes the character before it optional, or repeats it
+            case '?':
+            case '*':
+            case '{':
+                if (!run.empty())
+                    run.pop_back();
+                end_run();
+                if (c == '{')
+                    i = std::min(pattern.find('}', i), pattern.size());
+                continue;
+            case '+': end_run(); continue;
+
+            case '.':
+            case '^':
+            case '$': end_run(); continue;
+
+            case '[':
+                // "[]a]" and "[^]a]" have their first ']' in the class
+                i += i + 1 < pattern.size() && pattern[i + 1] == '^' ? 2 : 1;
+                if (i < pattern.size() && pattern[i] == ']')
+                    ++i;
+                for (; i < pattern.size() && pattern[i] != ']'; ++i)
+                    if (pattern[i] == '\\')
+                        ++i;
+                end_run();
+                continue;
+
+            case '(':
+            {
+                // skip the group, it may be quantified or hold an alternation
+                size_t depth = 0;
+                for (; i < pattern.size(); ++i)
+                {
+                    if (pattern[i] == '\\')
+                        ++i;
+                    else if (pattern[i] == '(')
+                        ++depth;
+                    else if (pattern[i] == ')' && --depth == 0)
+                        break;
+                }
+                end_run();
+                continue;
+            }
+
+            case '\\':
+                if (++i >= pattern.size())
+                    break;
+                c = pattern[i];
+
+                // \d, \w, \b, \n... are classes or assertions, only escaped punctuation is a literal
+                if (std::isalnum(static_cast<unsigned char>(c)))
+                {
+                    // \xHH, \uHHHH and \cX also take the characters after them
+                    if (c == 'x')
+                        i += 2;
+                    else if (c == 'u')
+                        i += 4;
+                    else if (c == 'c')
+                        i += 1;
+                    end_run();
+                    continue;
+                }
+                break;
+        }
+
+        run += c;
+    }
+    end_run();
+
+    return best;
+}
+
+// the code of a TOKEN_CODE token, up to its closing backtick, placeholders included as they're written
+static std::string_view code_line(const CompiledPage& page, size_t& t)
+{
+    const PageToken first = page.token(t);
+    size_t          end   = first.offset + first.length;
+    for (; t + 1 < page.token_count; ++t)
+    {
+        const PageToken token = page.token(t + 1);
+        if (token.kind < TOKEN_CODE_END)
+            break;
+        if (token.kind == TOKEN_CODE_END)
+        {
+            // the rest of the line is after the closing backtick
+            ++t;
+            break;
+        }
+        end = token.offset + token.length;
+    }
+
+    return page.markdown.substr(first.offset, end - first.offset);
+}
+
+bool grep_pages(const std::string_view pattern, const Config& config, const PageArchive& archive, OutputSink& out)
+{
+    std::regex regex;
+    try
+    {
+        regex.assign(pattern.begin(), pattern.end(), std::regex::ECMAScript | std::regex::optimize);
+    }
+    catch (const std::regex_error& e)
+    {
+        die("invalid regex \"{}\": {}", pattern, e.what());
+    }
+    const std::string& literal = required_literal(pattern);
+
+    // the examples are the same in the translations, so only the english pages are searched, once per platform
+    std::vector<size_t> entries;
+    for (size_t i = 0; i < archive.size(); ++i)
+        if (!archive.resolved(i) && hasStart(archive.name(i), "en/"))
+            entries.push_back(i);
+
+    const size_t             chunks = (entries.size() + GREP_CHUNK - 1) / GREP_CHUNK;
+    std::vector<std::string> found(chunks);
+    std::vector<bool>        done(chunks);
+    std::mutex               mutex;
+    std::condition_variable  ready;
+    std::atomic<size_t>      next = 0;
+    std::atomic<bool>        stop = false;
+
+    const auto& work = [&]() {
+        std::string  buf;
+        CompiledPage page;
+        for (size_t c; !stop && (c = next++) < chunks;)
+        {
+            std::string matches;
+            for (size_t e = c * GREP_CHUNK; e < std::min(entries.size(), (c + 1) * GREP_CHUNK); ++e)
+            {
+                // string_view::find() runs on memchr(), most pages are skipped without looking at a single line
+                const size_t i = entries[e];
+                if (!archive.compiled(i, buf, page) || page.markdown.find(literal) == page.markdown.npos)
+                    continue;
+
+                for (size_t t = 0; t < page.token_count; ++t)
+                {
+                    if (page.token(t).kind != TOKEN_CODE)
+                        continue;
+
+                    const std::string_view code = code_line(page, t);
+                    if (code.find(literal) == code.npos || !std::regex_search(code.begin(), code.end(), regex))
+                        continue;
+
+                    const std::string_view name    = archive.name(i);
+                    const size_t           second  = name.find('/', 3);
+                    const std::string_view command = name.substr(second + 1);
+                    const std::string_view where   = name.substr(3, second - 3);
+
+                    matches += fmt::format("{}{}{}{}: {}{}{}\n", config.clr_title, command, NOCOLOR,
+                                           platform_tag(where), config.clr_example_code, code, NOCOLOR);
+                }
+            }
+
+            std::lock_guard<std::mutex> lock(mutex);
+            found[c] = std::move(matches);
+            done[c]  = true;
+            ready.notify_all();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < std::min<size_t>(chunks, std::max(1u, std::thread::hardware_concurrency())); ++i)
+        threads.emplace_back(work);
+
+    bool any = false;
+    for (size_t c = 0; c < chunks; ++c)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready.wait(lock, [&]() { return done[c]; });
+        }
+
+        if (found[c].empty())
+            continue;
+
+        any = true;
+        if (!out.write(std::move(found[c])) || !out.flush())
+        {
+            // nobody reads the rest, don't search it
+            stop = true;
+            break;
+        }
+    }
+
+    for (std::thread& thread : threads)
+        thread.join();
+
+    return any;
+}
@@ -23,16 +23,270 @@
  *
  */
 
+#include <getopt.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <csignal>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
+
+#include "archive.hpp"
+#include "cache.hpp"
+#include "complete.hpp"
 #include "config.hpp"
+#include "fmt/ranges.h"
+#include "grep.hpp"
+#include "output.hpp"
+#include "pager.hpp"
 #include "parse.hpp"
+#include "search.hpp"
+#include "suggest.hpp"
+#include "update.hpp"
 #include "util.hpp"
 
+static void help(bool invalid_opt = false)
+{
+    constexpr std::string_view help(
+R"(Usage: wrapup [OPTIONS] <command>...
+A highly customizable and fast tldr client.
+
+OPTIONS:
+    -u, --update                Download the pages that changed upstream and rebuild the cache
+    -p, --pack                  Pack the pages cache directory into a single archive for faster lookups
+    -s, --search                Show the pages whose title, description or examples have all the words given
+    -g, --grep <regex>          Show the example code lines matching the regex, across every page
+    -c, --complete [prefix]     List the pages starting with prefix, for shell completion
+    -V, --version               Print version and other infos about the build
+    -h, --help                  Print this help menu
+)");
+
+    fmt::print("{}", help);
+    std::exit(invalid_opt);
+}
+
+static void version()
+{
+    fmt::println("wrapup {} branch {}", VERSION, BRANCH);
+    std::exit(EXIT_SUCCESS);
+}
+
+// pages are mostly waiting on the disk or the network, not on the CPU
+static constexpr size_t MAX_THREADS = 8;
+
+// Report the pages that couldn't be shown, with the closest names for the ones that don't exist, return false for them
+static bool check_result(const std::string_view page, const ParseResult result, const CacheGeneration& generation)
+{
+    if (result == ParseResult::NOT_FOUND)
+    {
+        SuggestIndex                  names;
+        std::vector<std::string_view> suggestions;
+        if (!generation.path().empty() && names.open(fmt::format("{}/{}", generation.path(), SUGGEST_INDEX_NAME)))
+            suggestions = names.suggest(page);
+
+        if (suggestions.empty())
+            error("page {} not found", page);
+        else
+            error("page {} not found, did you mean {}?", page, fmt::join(suggestions, ", "));
+    }
+
+    return result == ParseResult::RENDERED || result == ParseResult::CLOSED;
+}
+
+/* Render the pages concurrently, each into its own buffer, while writing them to out in order as soon as they're ready.
+ * So the first page shows up as soon as it's rendered, and the whole takes about as long as the slowest page.
+ * At most MAX_THREADS pages are rendered ahead of the one being written, so a pager waiting on the user holds few of them.
+ * @return false if some page couldn't be shown
+ */
+static bool show_pages(const std::vector<std::string_view>& pages, const Config& config, const PageArchive& archive,
+                       const CacheGeneration& generation, OutputSink& out)
+{
+    std::vector<MemorySink>  rendered(pages.size(), MemorySink(out.width()));
+    std::vector<ParseResult> results(pages.size());
+    std::vector<bool>        done(pages.size());
+    std::mutex               mutex;
+    std::condition_variable  ready;
+    std::atomic<size_t>      next = 0;
+    std::atomic<bool>        stop = false;
+    size_t                   shown = 0;
+
+    const auto& work = [&]() {
+        for (size_t i; !stop && (i = next++) < pages.size();)
+        {
+            {
+                // the pager blocks in write() until the user scrolls, don't render far ahead of it
+                std::unique_lock<std::mutex> lock(mutex);
+                ready.wait(lock, [&]() { return stop || i < shown + MAX_THREADS; });
+            }
+            if (stop)
+                break;
+
+            const ParseResult result = parse_page(pages[i], config, archive, rendered[i]);
+            rendered[i].flush();
+
+            std::lock_guard<std::mutex> lock(mutex);
+            results[i] = result;
+            done[i]    = true;
+            ready.notify_all();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < std::min(pages.size(), MAX_THREADS); ++i)
+        threads.emplace_back(work);
+
+    bool ok = true;
+    for (size_t i = 0; i < pages.size(); ++i)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            ready.wait(lock, [&]() { return done[i]; });
+        }
+
+        // the pages before it may still be queued in out, the error shouldn't come out ahead of them
+        if (results[i] == ParseResult::NOT_FOUND)
+            out.flush();
+
+        ok &= check_result(pages[i], results[i], generation);
+        const bool written = results[i] != ParseResult::RENDERED || out.write(rendered[i].str());
+        rendered[i] = MemorySink();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        ++shown;
+        // nobody reads the rest, don't start rendering it
+        stop = !written;
+        ready.notify_all();
+        if (stop)
+            break;
+    }
+
+    for (std::thread& thread : threads)
+        thread.join();
+
+    return ok;
+}
+
 int main (int argc, char *argv[])
 {
+    bool pack = false, update = false, search = false, complete = false;
+    const char* grep = nullptr;
+
+    const struct option long_options[] = {
+        {"update",   no_argument,       0, 'u'},
+        {"pack",     no_argument,       0, 'p'},
+        {"search",   no_argument,       0, 's'},
+        {"grep",     required_argument, 0, 'g'},
+        {"complete", no_argument,       0, 'c'},
+        {"version",  no_argument,       0, 'V'},
+        {"help",     no_argument,       0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "upsg:cVh", long_options, nullptr)) != -1)
+    {
+        switch (opt)
+        {
+            case 'u': update = true; break;
+            case 'p': pack = true; break;
+            case 's': search = true; break;
+            case 'g': grep = optarg; break;
+            case 'c': complete = true; break;
+            case 'V': version(); break;
+            case 'h': help(); break;
+            default:  help(true);
+        }
+    }
+
+    // runs on every TAB press, so it doesn't even read the config
+    if (complete)
+    {
+        CacheGeneration generation;
+        if (!generation.pin() || !complete_pages(generation.path(), optind < argc ? argv[optind] : ""))
+            die("no completion index in the cache, run --pack or --update to build it");
+        return 0;
+    }
+
     const std::string& configDir = getConfigDir();
 
     Config config(configDir + "/config.toml", configDir);
-    parse_page(argc < 2 ? "systemctl.md" : std::string(argv[1]) + ".md", config);
-    return 0;
+
+    if (update)
+    {
+        update_cache(config);
+        return 0;
+    }
+
+    if (pack)
+    {
+        GenerationBuilder  generation;
+        const std::string& archive_path = fmt::format("{}/{}", generation.path(), ARCHIVE_NAME);
+        const size_t       n            = pack_pages(getCacheDir(), archive_path);
+        build_search_index(generation.path());
+        build_suggest_index(generation.path());
+        build_complete_index(generation.path());
+        generation.commit();
+        info("packed {} pages into cache generation {}", n, generation.id());
+        return 0;
+    }
+
+    // pinned for the whole run, a concurrent --pack can't pull the cache from under us
+    CacheGeneration generation;
+    PageArchive     archive;
+    if (generation.pin())
+        archive.open(fmt::format("{}/{}", generation.path(), ARCHIVE_NAME));
+
+    // a closed pipe is reported by the output as EPIPE, so wrapup can stop instead of being killed
+    signal(SIGPIPE, SIG_IGN);
+    std::unique_ptr<OutputSink> out;
+    if (config.pager && isatty(STDOUT_FILENO))
+        out = std::make_unique<Pager>();
+    else
+        out = std::make_unique<FdSink>(STDOUT_FILENO);
+
+    if (search)
+    {
+        std::string query;
+        for (int i = optind; i < argc; ++i)
+            query += fmt::format("{}{}", i > optind ? " " : "", argv[i]);
+
+        SearchIndex index;
+        if (!archive.is_open() || !index.open(fmt::format("{}/{}", generation.path(), SEARCH_INDEX_NAME), archive))
+            die("no search index in the cache, run --pack or --update to build it");
+
+        const bool found = search_pages(query, config, archive, index, *out);
+        out->finish();
+        if (!found)
+            error("no page matches \"{}\"", query);
+        return found ? 0 : 1;
+    }
+
+    if (grep)
+    {
+        // the regex is the argument of --grep, so it can start with a dash (e.g "--grep -exec")
+        if (!archive.is_open())
+            die("no archive in the cache, run --pack or --update to build it");
+
+        const bool found = grep_pages(grep, config, archive, *out);
+        out->finish();
+        if (!found)
+            error("no example matches \"{}\"", grep);
+        return found ? 0 : 1;
+    }
+
+    std::vector<std::string_view> pages(argv + optind, argv + argc);
+    if (pages.empty())
+        pages.push_back("systemctl");
+
+    // a single page is rendered straight into the output, no need for threads and buffers
+    const bool ok = pages.size() == 1
+                        ? check_result(pages[0], parse_page(pages[0], config, archive, *out), generation)
+                        : show_pages(pages, config, archive, generation, *out);
+    out->finish();
+    return ok ? 0 : 1;
 }
@@ -0,0 +1,172 @@
+/*
+ * Copyright 2024 Toni500git
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ * disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "output.hpp"
+
+#include <sys/sendfile.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "util.hpp"
+
+bool OutputSink::write(std::string&& segment)
+{
+    if (this->is_closed)
+        return false;
+
+    this->pending += segment.size();
+    this->segments.push_back(std::move(segment));
+    return this->queued();
+}
+
+bool OutputSink::write(const std::string_view data)
+{
+    // small writes get merged into the last segment, no need for an iovec each
+    if (!this->segments.empty() && data.size() < 512 && this->segments.back().size() < 4096 && !this->is_closed)
+    {
+        this->segments.back() += data;
+        this->pending += data.size();
+        return this->queued();
+    }
+
+    return this->write(std::string(data));
+}
+
+bool OutputSink::queued()
+{ return this->pending < FLUSH_THRESHOLD && this->segments.size() < IOV_MAX ? true : this->flush(); }
+
+bool OutputSink::write_file(const int in_fd, const size_t size)
+{
+    std::string buf(size, '\0');
+    size_t      done = 0;
+    while (done < size)
+    {
+        const ssize_t n = read(in_fd, buf.data() + done, size - done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+        done += n;
+    }
+
+    return this->write(std::move(buf));
+}
+
+FdSink::FdSink(const int fd) : fd(fd), columns(get_terminal_width(fd))
+{}
+
+FdSink::~FdSink()
+{ this->flush(); }
+
+bool FdSink::flush()
+{
+    if (this->is_closed)
+        return false;
+
+    // stuff printed with fmt::print() before would come out after otherwise
+    if (this->fd == STDOUT_FILENO)
+        std::fflush(stdout);
+
+    std::vector<struct iovec> iov;
+    iov.reserve(this->segments.size());
+    for (std::string& segment : this->segments)
+        if (!segment.empty())
+            iov.push_back({ segment.data(), segment.size() });
+
+    size_t first = 0;
+    while (first < iov.size())
+    {
+        const ssize_t n = writev(this->fd, iov.data() + first, std::min<size_t>(iov.size() - first, IOV_MAX));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+        {
+            // the reader is gone (e.g "wrapup tar | head -1"), not worth an error
+            if (errno != EPIPE)
+                error("failed to write the output: {}", std::strerror(errno));
+            this->is_closed = true;
+            break;
+        }
+
+        // skip what got written, the last iovec may have only been written partially
+        size_t written = n;
+        while (first < iov.size() && written >= iov[first].iov_len)
+            written -= iov[first++].iov_len;
+        if (written > 0)
+        {
+            iov[first].iov_base = static_cast<char*>(iov[first].iov_base) + written;
+            iov[first].iov_len -= written;
+        }
+    }
+
+    this->segments.clear();
+    this->pending = 0;
+    return !this->is_closed;
+}
+
+bool FdSink::write_file(const int in_fd, const size_t size)
+{
+    if (!this->flush())
+        return false;
+
+    size_t done = 0;
+    while (done < size)
+    {
+        const ssize_t n = sendfile(this->fd, in_fd, nullptr, size - done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0 && errno == EPIPE)
+        {
+            this->is_closed = true;
+            return false;
+        }
+        // sendfile() can't write to every kind of fd, let the generic way do the rest
+        if (n <= 0)
+            return OutputSink::write_file(in_fd, size - done) && this->flush();
+        done += n;
+    }
+
+    return true;
+}
+
+bool MemorySink::flush()
+{
+    for (const std::string& segment : this->segments)
+        this->data += segment;
+
+    this->segments.clear();
+    this->pending = 0;
+    return true;
+}
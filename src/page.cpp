@@ -0,0 +1,249 @@
+/*
+ * Copyright 2024 Toni500git
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ * disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "page.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(__x86_64__) || defined(__i386__)
+# include <immintrin.h>
+#endif
+
+static void push_token(std::vector<PageToken>& tokens, const PageTokenKind kind, const size_t begin, const size_t end)
+{
+    PageToken token;
+    token.offset = begin;
+    token.length = end - begin;
+    token.kind   = kind;
+    tokens.push_back(token);
+}
+
+static void scan_markers_scalar(const char* data, const size_t begin, const size_t len, std::vector<uint32_t>& offsets)
+{
+    for (size_t i = begin; i < len; ++i)
+        if (data[i] == '`' || ((data[i] == '{' || data[i] == '}') && i + 1 < len && data[i + 1] == data[i]))
+            offsets.push_back(i);
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+// turn a mask of matches of a block starting at base into offsets
+static inline void push_mask(uint32_t mask, const size_t base, std::vector<uint32_t>& offsets)
+{
+    while (mask)
+    {
+        offsets.push_back(base + __builtin_ctz(mask));
+        mask &= mask - 1;
+    }
+}
+
+// a block matches where it has a backtick, or the same brace as the next byte
+__attribute__((target("sse2"))) static void scan_markers_sse2(const char* data, const size_t len,
+                                                             std::vector<uint32_t>& offsets)
+{
+    const __m128i backtick = _mm_set1_epi8('`'), open = _mm_set1_epi8('{'), close = _mm_set1_epi8('}');
+    size_t        i = 0;
+    for (; i + 16 < len; i += 16)
+    {
+        const __m128i cur  = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        const __m128i next = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 1));
+        const __m128i same = _mm_cmpeq_epi8(cur, next);
+        const __m128i hits = _mm_or_si128(
+            _mm_cmpeq_epi8(cur, backtick),
+            _mm_and_si128(same, _mm_or_si128(_mm_cmpeq_epi8(cur, open), _mm_cmpeq_epi8(cur, close))));
+        push_mask(_mm_movemask_epi8(hits), i, offsets);
+    }
+    scan_markers_scalar(data, i, len, offsets);
+}
+
+__attribute__((target("avx2"))) static void scan_markers_avx2(const char* data, const size_t len,
+                                                             std::vector<uint32_t>& offsets)
+{
+    const __m256i backtick = _mm256_set1_epi8('`'), open = _mm256_set1_epi8('{'), close = _mm256_set1_epi8('}');
+    size_t        i = 0;
+    for (; i + 32 < len; i += 32)
+    {
+        const __m256i cur  = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+        const __m256i next = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 1));
+        const __m256i same = _mm256_cmpeq_epi8(cur, next);
+        const __m256i hits = _mm256_or_si256(
+            _mm256_cmpeq_epi8(cur, backtick),
+            _mm256_and_si256(same, _mm256_or_si256(_mm256_cmpeq_epi8(cur, open), _mm256_cmpeq_epi8(cur, close))));
+        push_mask(_mm256_movemask_epi8(hits), i, offsets);
+    }
+    scan_markers_scalar(data, i, len, offsets);
+}
+#endif
+
+using MarkerScanner = void (*)(const char* data, const size_t len, std::vector<uint32_t>& offsets);
+
+static MarkerScanner pick_marker_scanner()
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return scan_markers_avx2;
+    if (__builtin_cpu_supports("sse2"))
+        return scan_markers_sse2;
+#endif
+    return [](const char* data, const size_t len, std::vector<uint32_t>& offsets) {
+        scan_markers_scalar(data, 0, len, offsets);
+    };
+}
+
+void scan_markers(const std::string_view data, std::vector<uint32_t>& offsets)
+{
+    static const MarkerScanner scanner = pick_marker_scanner();
+    scanner(data.data(), data.size(), offsets);
+}
+
+/* Tokenize the rest of an example code line, after its opening backtick, from begin to end of content:
+ * the first backtick closes the code, and every {{ opens a placeholder,
+ * a }} only closes one if there's a {{ before it which isn't closed yet.
+ * @param marker The first of the marker offsets which is at or after begin, moved past the line
+ */
+static void compile_code(const std::string_view content, size_t begin, const size_t end,
+                         const std::vector<uint32_t>& markers, size_t& marker, std::vector<PageToken>& tokens)
+{
+    bool          closed  = false;
+    size_t        pending = 0;
+    PageTokenKind kind    = TOKEN_CODE;
+    for (; marker < markers.size() && markers[marker] < end; ++marker)
+    {
+        // the second brace of a marker which was already taken, e.g "{{{"
+        const size_t i = markers[marker];
+        if (i < begin)
+            continue;
+
+        PageTokenKind next;
+        size_t        skip = 2;
+        if (content[i] == '`')
+        {
+            if (closed)
+                continue;
+
+            closed = true;
+            next   = TOKEN_CODE_END;
+            skip   = 1;
+        }
+        else if (content[i] == '{')
+        {
+            next = TOKEN_PLACEHOLDER;
+            ++pending;
+        }
+        else if (pending > 0)
+        {
+            next = TOKEN_PLACEHOLDER_END;
+            --pending;
+        }
+        else
+        {
+            continue;
+        }
+
+        push_token(tokens, kind, begin, i);
+        kind  = next;
+        begin = i + skip;
+    }
+    push_token(tokens, kind, begin, end);
+}
+
+void compile_page(const std::string_view content, std::vector<PageToken>& tokens)
+{
+    // all the markers of the page are found in one pass, the lines then just take theirs in order
+    std::vector<uint32_t> markers;
+    scan_markers(content, markers);
+
+    size_t marker = 0;
+    size_t begin  = 0;
+    while (begin < content.size())
+    {
+        size_t end = content.find('\n', begin);
+        if (end == content.npos)
+            end = content.size();
+
+        const size_t line = begin;
+        begin = end + 1;
+        if (line == end)
+            continue;
+
+        switch (content[line])
+        {
+            case '#': push_token(tokens, TOKEN_TITLE, line + 1, end); break;
+            case '>': push_token(tokens, TOKEN_DESCRIPTION, line + 1, end); break;
+            case '-': push_token(tokens, TOKEN_EXAMPLE, std::min(line + 2, end), end); break;
+            case '`':
+                while (marker < markers.size() && markers[marker] <= line)
+                    ++marker;
+                compile_code(content, line + 1, end, markers, marker, tokens);
+                break;
+            default:  push_token(tokens, TOKEN_TEXT, line, end);
+        }
+    }
+}
+
+void compile_page(const std::string_view content, std::string& out)
+{
+    std::vector<PageToken> tokens;
+    compile_page(content, tokens);
+
+    const uint32_t token_count   = tokens.size();
+    const uint32_t markdown_size = content.size();
+    out.assign(content);
+    out.append((4 - content.size() % 4) % 4, '\0');
+    out.append(reinterpret_cast<const char*>(tokens.data()), tokens.size() * sizeof(PageToken));
+    out.append(reinterpret_cast<const char*>(&token_count), sizeof(token_count));
+    out.append(reinterpret_cast<const char*>(&markdown_size), sizeof(markdown_size));
+}
+
+bool read_compiled_page(const std::string_view data, CompiledPage& page)
+{
+    uint32_t token_count, markdown_size;
+    if (data.size() < sizeof(token_count) + sizeof(markdown_size))
+        return false;
+
+    const char* trailer = data.data() + data.size() - sizeof(token_count) - sizeof(markdown_size);
+    std::memcpy(&token_count, trailer, sizeof(token_count));
+    std::memcpy(&markdown_size, trailer + sizeof(token_count), sizeof(markdown_size));
+
+    const size_t tokens_off = (markdown_size + 3) & ~size_t(3);
+    if (tokens_off + uint64_t(token_count) * sizeof(PageToken) != size_t(trailer - data.data()))
+        return false;
+
+    page.markdown    = data.substr(0, markdown_size);
+    page.tokens      = data.data() + tokens_off;
+    page.token_count = token_count;
+    for (size_t i = 0; i < token_count; ++i)
+    {
+        const PageToken token = page.token(i);
+        if (token.offset + token.length > markdown_size)
+            return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,291 @@
+/*
+ * Copyright 2024 Toni500git
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ * disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "pager.hpp"
+
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstdio>
+#include <string>
+#include <string_view>
+
+#include "render.hpp"
+#include "util.hpp"
+
+static volatile std::sig_atomic_t resized = 0;
+
+static void on_sigwinch(int)
+{ resized = 1; }
+
+static void write_tty(const std::string_view data)
+{
+    size_t done = 0;
+    while (done < data.size())
+    {
+        const ssize_t n = write(STDOUT_FILENO, data.data() + done, data.size() - done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return;
+        done += n;
+    }
+}
+
+Pager::Pager() : stdout_sink(STDOUT_FILENO)
+{
+    this->tty = open("/dev/tty", O_RDONLY | O_CLOEXEC);
+    this->resize();
+}
+
+Pager::~Pager()
+{
+    this->leave();
+    if (this->tty >= 0)
+        close(this->tty);
+}
+
+void Pager::resize()
+{
+    struct winsize ws;
+    if (ioctl(STDOUT_FILENO, TIOCGWINSZ, &ws) == 0 && ws.ws_row > 1 && ws.ws_col > 0)
+    {
+        this->screen_rows = ws.ws_row;
+        this->screen_cols = ws.ws_col;
+    }
+
+    // keep the line at the top of the screen there
+    const size_t line = this->top < this->rows.size() ? this->rows[this->top].line : 0;
+    this->rows.clear();
+    this->wrap(0);
+    this->top = 0;
+    while (this->top + 1 < this->rows.size() && this->rows[this->top].line < line)
+        ++this->top;
+}
+
+void Pager::wrap(const size_t first_line)
+{
+    std::string wrapped;
+    for (size_t i = first_line; i < this->lines.size(); ++i)
+    {
+        wrap_rendered_line(this->lines[i], this->screen_cols, wrapped);
+        for (const std::string& row : split(wrapped, '\n'))
+            this->rows.push_back({ i, row });
+        if (wrapped.empty())
+            this->rows.push_back({ i, "" });
+    }
+}
+
+void Pager::ingest()
+{
+    const size_t first_line = this->lines.size();
+    for (const std::string& segment : this->segments)
+    {
+        size_t begin = 0, end;
+        while ((end = segment.find('\n', begin)) != segment.npos)
+        {
+            this->partial.append(segment, begin, end - begin);
+            this->lines.push_back(std::move(this->partial));
+            this->partial.clear();
+            begin = end + 1;
+        }
+        this->partial.append(segment, begin);
+    }
+
+    this->segments.clear();
+    this->pending = 0;
+    if (!this->more && !this->partial.empty())
+    {
+        this->lines.push_back(std::move(this->partial));
+        this->partial.clear();
+    }
+
+    this->wrap(first_line);
+}
+
+void Pager::enter()
+{
+    if (this->active || this->tty < 0)
+        return;
+
+    tcgetattr(this->tty, &this->saved_termios);
+    struct termios raw = this->saved_termios;
+    // Ctrl-C is read as a key, so the terminal always gets restored
+    raw.c_lflag &= ~(ICANON | ECHO | ISIG);
+    raw.c_cc[VMIN]  = 1;
+    raw.c_cc[VTIME] = 0;
+    tcsetattr(this->tty, TCSAFLUSH, &raw);
+
+    // no SA_RESTART, so a resize interrupts the read() of the keys
+    struct sigaction sa{};
+    sa.sa_handler = on_sigwinch;
+    sigaction(SIGWINCH, &sa, nullptr);
+
+    std::fflush(stdout);
+    write_tty("\033[?1049h\033[?25l");
+    this->active = true;
+}
+
+void Pager::leave()
+{
+    if (!this->active)
+        return;
+
+    write_tty("\033[?25h\033[?1049l");
+    tcsetattr(this->tty, TCSAFLUSH, &this->saved_termios);
+    signal(SIGWINCH, SIG_DFL);
+    this->active = false;
+}
+
+void Pager::draw()
+{
+    const size_t body = this->screen_rows - 1;
+    std::string  screen = "\033[H";
+    for (size_t i = this->top; i < this->top + body; ++i)
+    {
+        // cleared first, the tabs of the code lines move over what was there without erasing it
+        screen += "\033[2K";
+        if (i < this->rows.size())
+            screen += this->rows[i].text;
+        screen += "\033[0m\r\n";
+    }
+
+    const bool end = !this->more && this->top + body >= this->rows.size();
+    screen += end ? "\033[2K\033[7m(END)\033[0m" : "\033[2K\033[7m:\033[0m";
+    write_tty(screen);
+}
+
+bool Pager::interact()
+{
+    const size_t body = this->screen_rows - 1;
+    const auto&  last_top = [this, body]() { return this->rows.size() > body ? this->rows.size() - body : 0; };
+
+    char key[16];
+    for (;;)
+    {
+        if (resized)
+        {
+            resized = 0;
+            this->resize();
+        }
+
+        // scrolled past what was written, let more be written first
+        if (this->more && (this->to_end || this->top + body > this->rows.size()))
+            return true;
+
+        if (this->to_end)
+            this->top = this->rows.size();
+        this->to_end = false;
+        this->top    = std::min(this->top, last_top());
+        this->draw();
+
+        const ssize_t n = read(this->tty, key, sizeof(key));
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            return false;
+
+        const std::string_view k(key, n);
+        const size_t           page = std::max<size_t>(1, this->screen_rows - 2);
+        if (k == "q" || k == "Q" || k == "\x03")
+            return false;
+        else if (k == "j" || k == "\r" || k == "\n" || k == "\033[B" || k == "\033OB")
+            ++this->top;
+        else if (k == "k" || k == "\033[A" || k == "\033OA")
+            this->top -= this->top > 0;
+        else if (k == " " || k == "f" || k == "\033[6~")
+            this->top += page;
+        else if (k == "b" || k == "\033[5~")
+            this->top -= std::min(this->top, page);
+        else if (k == "g" || k == "<" || k == "\033[H")
+            this->top = 0;
+        else if (k == "G" || k == ">" || k == "\033[F")
+            this->to_end = true;
+    }
+}
+
+bool Pager::print_rows()
+{
+    for (const Row& row : this->rows)
+        this->stdout_sink.write(row.text + '\n');
+    this->lines.clear();
+    this->rows.clear();
+
+    if (!this->stdout_sink.flush())
+        this->is_closed = true;
+    return !this->is_closed;
+}
+
+bool Pager::queued()
+{
+    if (this->is_closed)
+        return false;
+
+    this->ingest();
+
+    // no keys to read, so nothing to page
+    if (this->tty < 0)
+        return this->print_rows();
+
+    // nothing to show until there's a screenful
+    if (!this->active && this->rows.size() < this->screen_rows)
+        return true;
+
+    this->enter();
+    if (!this->interact())
+    {
+        this->leave();
+        this->is_closed = true;
+    }
+
+    return !this->is_closed;
+}
+
+bool Pager::flush()
+{ return this->queued(); }
+
+bool Pager::finish()
+{
+    if (this->is_closed)
+        return false;
+
+    this->more = false;
+    this->ingest();
+
+    // it all fits, no need to page it
+    if (this->tty < 0 || (!this->active && this->rows.size() < this->screen_rows))
+        return this->print_rows();
+
+    this->enter();
+    this->interact();
+    this->leave();
+    this->is_closed = true;
+    return true;
+}
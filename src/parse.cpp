@@ -25,21 +25,23 @@
 
 #include "parse.hpp"
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdlib>
-#include <filesystem>
-#include <fstream>
+#include <cstring>
 #include <string>
 #include <string_view>
+#include <vector>
 
+#include "archive.hpp"
 #include "config.hpp"
+#include "fetch.hpp"
 #include "fmt/base.h"
+#include "output.hpp"
+#include "render.hpp"
+#include "render_cache.hpp"
 #include "util.hpp"
 
-#if ONLINE
-# include "cpr/cpr.h"
-#endif
-
 // this is why I unironically like C/C++ being OS depended
 std::string get_platform()
 {
@@ -71,68 +73,119 @@ std::string get_platform()
     return "common";
 }
 
-void parse_page(const std::string_view page, const Config& config)
+/* Get the languages to look for pages in, in order of preference (as the tldr client specification says)
+ * @return the language codes from $LANGUAGE and $LANG, always ending with english
+ */
+std::vector<std::string> get_languages()
 {
-    std::string path = fmt::format("{}/pages/{}/{}", getCacheDir(), get_platform(), page);
-    std::fstream f(path);
-    if (!f.is_open())
+    std::vector<std::string> ret;
+    const auto& add = [&ret](const std::string& language) {
+        if (!language.empty() && std::find(ret.begin(), ret.end(), language) == ret.end())
+            ret.push_back(language);
+    };
+
+    // $LANGUAGE is only taken into account if $LANG is set
+    const char* lang = std::getenv("LANG");
+    if (lang && lang[0] != '\0' && std::strcmp(lang, "C") != 0 && std::strcmp(lang, "POSIX") != 0)
     {
-#if ONLINE
-        path = fmt::format("{}/wrapup_tmp_pages_{}_{}", std::filesystem::temp_directory_path().string(),
-                                      get_platform(), page);
-        std::ofstream out(path);
-        cpr::Session session;
-        session.SetUrl(cpr::Url(fmt::format("https://raw.githubusercontent.com/tldr-pages/tldr/refs/heads/main/pages/{}/{}", get_platform(), page)));
-        const cpr::Response& r = session.Download(out);
-
-        if (r.status_code == 200)
+        const char*              language = std::getenv("LANGUAGE");
+        std::vector<std::string> locales  = language ? split(language, ':') : std::vector<std::string>();
+        locales.push_back(lang);
+
+        // "pt_BR.UTF-8" -> "pt_BR", "pt"
+        for (std::string& locale : locales)
         {
-            f.open(path);
-            if (!f.is_open())
-                die("failed to open {}", path);
-            goto parse;
+            locale.erase(std::min(locale.find('.'), locale.find('@')), std::string::npos);
+            add(locale);
+            add(locale.substr(0, locale.find('_')));
         }
-#endif
-
-        path = fmt::format("{}/pages/common/{}", getCacheDir(), page);
-        f.open(path);
-        if (!f.is_open())
-            die("failed to open {}", path);
     }
 
-    debug("path = {}", path);
+    add("en");
+    return ret;
+}
 
-parse:
-    std::string line;
-    while (std::getline(f, line))
+std::string platform_tag(const std::string_view platform)
+{
+    if (platform == "common" || platform == get_platform())
+        return {};
+    return fmt::format(" ({})", platform);
+}
+
+// ParseResult::RENDERED, or ParseResult::CLOSED if out got closed
+static ParseResult written(const bool ok)
+{ return ok ? ParseResult::RENDERED : ParseResult::CLOSED; }
+
+ParseResult parse_page(const std::string_view page, const Config& config, const PageArchive& archive,
+                       OutputSink& out)
+{
+    // fast path: the page is read already compiled from the mmap()ed archive,
+    // which also resolved the fallback to common or other platforms
+    std::string  buf, rendered;
+    CompiledPage compiled;
+    for (const std::string& language : get_languages())
     {
-        if (line.empty())
+        const size_t i = archive.lookup(language, get_platform(), page);
+        if (i == PageArchive::npos)
             continue;
 
-        switch (line.front())
+        // a hit doesn't even need to decompress the page
+        if (config.cache_rendered)
         {
-            case '#': line.replace(0, 1, config.clr_title); fmt::print("\n\n"); break;
-            case '>': line.replace(0, 1, config.clr_description); break;
-            case '-':
-                line.replace(1, 1, config.clr_example_text + " ");
-                fmt::print("\n");
-                break;
-            case '`':
-                line.replace(0, 1, config.clr_example_code);
-                line.replace(line.find('`', 2), 1, NOCOLOR);
-                size_t pos = 0;
-                while ((pos = line.find("{{")) != line.npos)
+            const RenderCache::SendResult sent = RenderCache(config, out.width()).send(archive.content_hash(i), out);
+            if (sent != RenderCache::SendResult::NOT_CACHED)
+            {
+                debug("page {} found in the rendered cache ({})", page, language);
+                return written(sent == RenderCache::SendResult::SENT);
+            }
+        }
+
+        if (archive.compiled(i, buf, compiled))
+        {
+            debug("page {} found in archive ({})", page, language);
+            render_page(compiled, config, out.width(), rendered);
+            if (config.cache_rendered)
+                RenderCache(config, out.width()).store(archive.content_hash(i), rendered);
+            return written(out.write(std::move(rendered)));
+        }
+    }
+
+    std::string path = fmt::format("{}/pages/{}/{}.md", getCacheDir(), get_platform(), page);
+    if (!read_file(path, buf))
+    {
+        // most of the pages are in common, so check it before going to the network
+        path = fmt::format("{}/pages/common/{}.md", getCacheDir(), page);
+        if (!read_file(path, buf))
+        {
+#if ONLINE
+            // revalidated against the copy from the last time, if any, so repeated lookups stay cheap
+            path = fmt::format("{}/pages/{}/{}.md", config.update_pages_url, get_platform(), page);
+            if (is_known_miss(path))
+            {
+                debug("page {} is a cached miss, run --update to look again", page);
+                return ParseResult::NOT_FOUND;
+            }
+
+            long status = 0;
+            if (!fetch_url(path, buf, status))
+            {
+                if (status == 404)
                 {
-                    line.replace(pos, 2, "\033[04m");
-                    pos = line.find("}}", pos);
-                    if (pos != line.npos)
-                    line.replace(pos, 2, "\033[0m"+config.clr_example_code);
+                    remember_miss(path);
+                    return ParseResult::NOT_FOUND;
                 }
-                fmt::println("  \t{}\033[0m", line);
-                continue;
-        }
 
-        fmt::println("  {}\033[0m", line);
+                error("failed to download {}: {}", path, status);
+                return ParseResult::FAILED;
+            }
+#else
+            debug("failed to open {}", path);
+            return ParseResult::NOT_FOUND;
+#endif
+        }
     }
-    fmt::print("\n\n");
+
+    debug("path = {}", path);
+    render_page(buf, config, out.width(), rendered);
+    return written(out.write(std::move(rendered)));
 }
@@ -0,0 +1,206 @@
+/*
+ * Copyright 2024 Toni500git
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ * disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "render.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "config.hpp"
+#include "page.hpp"
+#include "util.hpp"
+#include "width.hpp"
+
+constexpr std::string_view UNDERLINE = "\033[04m";
+
+// columns the tab of the code lines can take
+constexpr size_t TAB_WIDTH = 8;
+
+// skip the escape sequence at the start of str, e.g "\033[1;34m"
+static size_t escape_length(const std::string_view str)
+{
+    size_t i = 1;
+    if (i < str.size() && str[i] == '[')
+        while (++i < str.size() && !(str[i] >= 0x40 && str[i] <= 0x7e))
+            ;
+    return std::min(i + 1, str.size());
+}
+
+/* Soft wrap the line at the end of out so it fits in width columns, breaking at the last space that fits
+ * (or in the middle of a word longer than the whole line). Continuation lines are indented with spaces up to
+ * the column of the first word, so they line up with the text of the first line whatever its marker is.
+ * Escapes take no room, and characters take as many columns as codepoint_width() says.
+ * @param line_start Where the line starts in out
+ * @param text_start Where its text starts in out, after the marker and the colors, nothing before gets broken
+ */
+static void wrap_line(std::string& out, const size_t line_start, const size_t text_start, const size_t width)
+{
+    // no character takes more columns than bytes, except the tab of the code lines
+    if (out.size() - line_start + TAB_WIDTH <= width)
+        return;
+
+    static thread_local std::string line;
+    line.assign(out, line_start, std::string::npos);
+    out.resize(line_start);
+
+    const std::string_view view = line;
+    size_t                 col = 0, emitted = 0, space = std::string::npos, space_col = 0;
+    // the column of the first word, nothing gets broken before it
+    size_t                 indent = std::string::npos;
+    for (size_t i = 0; i < view.size();)
+    {
+        const char c = view[i];
+        if (c == '\033')
+        {
+            i += escape_length(view.substr(i));
+            continue;
+        }
+
+        if (c == '\t')
+        {
+            col = (col / TAB_WIDTH + 1) * TAB_WIDTH;
+            ++i;
+            continue;
+        }
+
+        uint32_t     cp;
+        const size_t len  = c & 0x80 ? decode_utf8(view.substr(i), cp) : 1;
+        const size_t cols = c & 0x80 ? codepoint_width(cp) : 1;
+        const bool   text = line_start + i >= text_start;
+        if (text && c != ' ' && indent == std::string::npos)
+            indent = col;
+
+        if (indent != std::string::npos && col + cols > width && col > indent)
+        {
+            // break at the last space if there's one, else right here
+            const size_t at = space != std::string::npos ? space : i;
+            out.append(view, emitted, at - emitted).append("\n").append(indent, ' ');
+            col     = indent + (space != std::string::npos ? col - space_col - 1 : 0);
+            emitted = space != std::string::npos ? space + 1 : i;
+            space   = std::string::npos;
+        }
+
+        // the spaces before the first word don't separate any words
+        if (c == ' ' && indent != std::string::npos)
+        {
+            space     = i;
+            space_col = col;
+        }
+
+        col += cols;
+        i += len;
+    }
+
+    out.append(view, emitted);
+}
+
+template <typename ThemeT>
+static void render_tokens(const CompiledPage& page, const ThemeT& theme, const size_t width, std::string& out)
+{
+    // escapes only add a few bytes per token, this avoids growing the buffer in the middle of the page
+    out.reserve(out.size() + page.markdown.size() + page.token_count * 16 + 64);
+
+    size_t line_start = 0, text_start = 0;
+    for (size_t i = 0; i < page.token_count; ++i)
+    {
+        const PageToken token = page.token(i);
+        if (token.kind < TOKEN_CODE_END)
+        {
+            if (i > 0)
+            {
+                if (width > 0)
+                    wrap_line(out, line_start, text_start, width);
+                out.append(NOCOLOR).append("\n");
+            }
+
+            if (token.kind == TOKEN_TITLE)
+                out.append("\n\n");
+            else if (token.kind == TOKEN_EXAMPLE)
+                out.append("\n");
+
+            line_start = out.size();
+        }
+
+        switch (token.kind)
+        {
+            case TOKEN_TITLE:           out.append(theme.title); break;
+            case TOKEN_DESCRIPTION:     out.append(theme.description); break;
+            case TOKEN_EXAMPLE:         out.append(theme.example); break;
+            case TOKEN_CODE:            out.append(theme.code); break;
+            case TOKEN_TEXT:            out.append("  "); break;
+            case TOKEN_CODE_END:        out.append(NOCOLOR); break;
+            case TOKEN_PLACEHOLDER:     out.append(UNDERLINE); break;
+            case TOKEN_PLACEHOLDER_END: out.append(theme.placeholder_end); break;
+        }
+
+        if (token.kind < TOKEN_CODE_END)
+            text_start = out.size();
+        out.append(page.text(token));
+    }
+
+    if (page.token_count > 0)
+    {
+        if (width > 0)
+            wrap_line(out, line_start, text_start, width);
+        out.append(NOCOLOR).append("\n");
+    }
+    out.append("\n\n");
+}
+
+void render_page(const CompiledPage& page, const Config& config, const size_t width, std::string& out)
+{
+    if (config.default_theme)
+        render_tokens(page, DefaultTheme{}, width, out);
+    else
+        render_tokens(page, config.theme, width, out);
+}
+
+void render_page(const std::string_view content, const Config& config, const size_t width, std::string& out)
+{
+    std::vector<PageToken> tokens;
+    compile_page(content, tokens);
+
+    CompiledPage page;
+    page.markdown    = content;
+    page.tokens      = reinterpret_cast<const char*>(tokens.data());
+    page.token_count = tokens.size();
+    render_page(page, config, width, out);
+}
+
+void wrap_rendered_line(const std::string_view line, const size_t width, std::string& out)
+{
+    // the text starts after the marker and the colors following it
+    const std::string_view marker     = hasStart(line, "  \t") ? "  \t" : hasStart(line, "  -") ? "  -" : "  ";
+    size_t                 text_start = std::min(line.size(), marker.size());
+    while (text_start < line.size() && line[text_start] == '\033')
+        text_start += escape_length(line.substr(text_start));
+
+    out.assign(line);
+    if (width > 0)
+        wrap_line(out, 0, text_start, width);
+}
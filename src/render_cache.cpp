@@ -0,0 +1,80 @@
+/*
+ * Copyright 2024 Toni500git
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ * disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "render_cache.hpp"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <string>
+#include <string_view>
+
+#include "config.hpp"
+#include "util.hpp"
+
+RenderCache::RenderCache(const Config& config, const size_t width)
+    : dir(getCacheDir() + "/rendered"), max_size(config.cache_rendered_max_size)
+{
+    const std::string& theme = fmt::format("{}\n{}\n{}\n{}", config.clr_title, config.clr_description,
+                                           config.clr_example_text, config.clr_example_code);
+    const uint64_t     terminal[2] = { width, static_cast<uint64_t>(config.color_depth) };
+    this->key_seed = hash_bytes(terminal, sizeof(terminal), hash_bytes(theme.data(), theme.size()));
+}
+
+std::string RenderCache::entry_path(const uint64_t content_hash) const
+{ return fmt::format("{}/{:016x}", this->dir, hash_bytes(&content_hash, sizeof(content_hash), this->key_seed)); }
+
+RenderCache::SendResult RenderCache::send(const uint64_t content_hash, OutputSink& out) const
+{
+    const int in = open(this->entry_path(content_hash).c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0)
+        return SendResult::NOT_CACHED;
+
+    struct stat st;
+    if (fstat(in, &st) < 0)
+    {
+        close(in);
+        return SendResult::NOT_CACHED;
+    }
+
+    // a hit counts as a use, see the class comment
+    futimens(in, nullptr);
+
+    const bool ok = out.write_file(in, st.st_size);
+    close(in);
+    return ok ? SendResult::SENT : SendResult::WRITE_FAILED;
+}
+
+void RenderCache::store(const uint64_t content_hash, const std::string_view output) const
+{
+    if (!replace_file(this->entry_path(content_hash), output))
+    {
+        debug("failed to cache the rendered page {:016x}", content_hash);
+        return;
+    }
+
+    evict_least_recently_used(this->dir, this->max_size);
+}
@@ -0,0 +1,405 @@
+/*
+ * Copyright 2024 Toni500git
+ * 
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ * disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "search.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "cache.hpp"
+#include "parse.hpp"
+#include "util.hpp"
+
+// longer words are most likely not words (hashes, base64...) and nobody searches for them
+constexpr size_t MAX_TERM_LENGTH = 64;
+
+// BM25 parameters: how fast the score saturates as a term repeats, and how much the length of a page matters
+constexpr float BM25_K1 = 1.2f;
+constexpr float BM25_B  = 0.75f;
+
+struct Posting
+{
+    uint32_t entry;
+    uint32_t frequency;
+};
+
+void split_terms(const std::string_view text, std::vector<std::string>& terms)
+{
+    std::string term;
+    for (size_t i = 0; i <= text.size(); ++i)
+    {
+        const unsigned char c = i < text.size() ? text[i] : ' ';
+        if (std::isalnum(c) || c >= 0x80)
+        {
+            term += std::tolower(c);
+            continue;
+        }
+
+        // the mnemonics of the options, e.g "[c]reate" or "[f]ile"
+        if ((c == '[' || c == ']') && i + 1 < text.size() && std::isalnum(static_cast<unsigned char>(text[i + 1])))
+            continue;
+
+        // single letters match about everything
+        if (term.size() > 1 && term.size() <= MAX_TERM_LENGTH)
+            terms.push_back(term);
+        term.clear();
+
+        // "<https://example.com>", the link of every page
+        if (c == '<')
+        {
+            const size_t end = text.find_first_of("> ", i);
+            if (end != text.npos && text[end] == '>')
+                i = end;
+        }
+    }
+}
+
+/* Decode the postings of a term
+ * @param data The encoded postings
+ * @param postings Where to put them
+ * @return false if they're truncated
+ */
+static bool read_postings(const std::string_view data, std::vector<Posting>& postings)
+{
+    uint32_t entry = 0;
+    for (size_t i = 0; i < data.size();)
+    {
+        uint32_t delta, frequency;
+        if (!read_varint(data, i, delta) || !read_varint(data, i, frequency))
+            return false;
+
+        entry += delta;
+        postings.push_back({ entry, frequency });
+    }
+
+    return true;
+}
+
+SearchIndex::~SearchIndex()
+{ this->close(); }
+
+void SearchIndex::close()
+{ this->file.close(); }
+
+bool SearchIndex::open(const std::string_view path, const PageArchive& archive)
+{
+    this->close();
+
+    if (!this->file.open(path, sizeof(SearchHeader)))
+        return false;
+
+    const SearchHeader* hdr = this->header();
+    if (!this->file.has_header(SEARCH_MAGIC, SEARCH_VERSION) ||
+        hdr->file_size != this->file.size() || hdr->entry_count != archive.size() ||
+        hdr->terms_off < sizeof(SearchHeader) || hdr->terms_off % alignof(SearchTerm) != 0 ||
+        hdr->terms_off + hdr->term_count * sizeof(SearchTerm) > hdr->lengths_off ||
+        hdr->lengths_off % alignof(uint32_t) != 0 ||
+        hdr->lengths_off + uint64_t(hdr->entry_count) * sizeof(uint32_t) > hdr->strings_off ||
+        hdr->strings_off > hdr->postings_off || hdr->postings_off > this->file.size())
+    {
+        warn("search index {} is corrupted or outdated, ignoring it", path);
+        this->close();
+        return false;
+    }
+
+    return true;
+}
+
+const SearchTerm* SearchIndex::find(const std::string_view term) const
+{
+    const SearchTerm* begin = this->terms();
+    const SearchTerm* end   = begin + this->header()->term_count;
+    const SearchTerm* it    = std::lower_bound(
+        begin, end, term, [this](const SearchTerm& t, const std::string_view key) { return this->term(t) < key; });
+
+    return it != end && this->term(*it) == term ? it : nullptr;
+}
+
+std::vector<SearchMatch> SearchIndex::search(const std::string_view query) const
+{
+    std::vector<std::string> words;
+    split_terms(query, words);
+    std::sort(words.begin(), words.end());
+    words.erase(std::unique(words.begin(), words.end()), words.end());
+
+    std::vector<const SearchTerm*> terms;
+    for (const std::string& word : words)
+    {
+        const SearchTerm* term = this->find(word);
+        if (!term)
+            return {};
+        terms.push_back(term);
+    }
+
+    if (terms.empty())
+        return {};
+
+    // start from the rarest term, the intersection only gets smaller
+    std::sort(terms.begin(), terms.end(),
+              [](const SearchTerm* a, const SearchTerm* b) { return a->page_count < b->page_count; });
+
+    const SearchHeader* hdr        = this->header();
+    const float         avg_length = hdr->total_length ? float(hdr->total_length) / hdr->page_count : 1.0f;
+
+    std::vector<SearchMatch> matches;
+    std::vector<Posting>     postings;
+    for (size_t t = 0; t < terms.size(); ++t)
+    {
+        const SearchTerm& term = *terms[t];
+        const uint64_t    off  = hdr->postings_off + term.postings_off;
+        postings.clear();
+        if (off + term.postings_len > this->file.size() ||
+            !read_postings({ this->file.data() + off, term.postings_len }, postings) ||
+            (!postings.empty() && postings.back().entry >= hdr->entry_count))
+        {
+            error("search index: the postings of \"{}\" are corrupted", this->term(term));
+            return {};
+        }
+
+        // BM25: rare terms weigh more, and repeating a term counts less and less, relative to the page length
+        const float idf = std::log(1.0f + (float(hdr->page_count) - term.page_count + 0.5f) / (term.page_count + 0.5f));
+        const auto& score = [&](const Posting& posting) {
+            const float norm = 1.0f - BM25_B + BM25_B * this->lengths()[posting.entry] / avg_length;
+            return idf * posting.frequency * (BM25_K1 + 1.0f) / (posting.frequency + BM25_K1 * norm);
+        };
+
+        if (t == 0)
+        {
+            for (const Posting& posting : postings)
+                matches.push_back({ posting.entry, score(posting) });
+            continue;
+        }
+
+        // both are sorted by entry
+        size_t kept = 0, p = 0;
+        for (const SearchMatch& match : matches)
+        {
+            while (p < postings.size() && postings[p].entry < match.entry)
+                ++p;
+            if (p == postings.size())
+                break;
+            if (postings[p].entry == match.entry)
+                matches[kept++] = { match.entry, match.score + score(postings[p]) };
+        }
+        matches.resize(kept);
+    }
+
+    return matches;
+}
+
+size_t build_search_index(const std::string_view generation_dir)
+{
+    const std::string& archive_path = fmt::format("{}/{}", generation_dir, ARCHIVE_NAME);
+    PageArchive        archive;
+    if (!archive.open(archive_path))
+        die("failed to open {}", archive_path);
+
+    // entries are visited in order, so the postings of every term come out sorted
+    std::unordered_map<std::string, std::vector<Posting>> index;
+    std::vector<uint32_t>                                 lengths(archive.size());
+    uint32_t                                              page_count   = 0;
+    uint64_t                                              total_length = 0;
+    std::vector<std::string>                              words;
+    std::string                                           buf;
+    CompiledPage                                          page;
+    for (size_t i = 0; i < archive.size(); ++i)
+    {
+        // fallbacks are the same page as another entry
+        if (archive.resolved(i) || !archive.compiled(i, buf, page))
+            continue;
+
+        for (size_t t = 0; t < page.token_count; ++t)
+        {
+            const PageToken token  = page.token(t);
+            const uint32_t  weight = token.kind == TOKEN_TITLE         ? WEIGHT_TITLE
+                                     : token.kind == TOKEN_DESCRIPTION ? WEIGHT_DESCRIPTION
+                                     : token.kind == TOKEN_EXAMPLE     ? WEIGHT_EXAMPLE
+                                                                       : 0;
+            if (weight == 0)
+                continue;
+
+            words.clear();
+            split_terms(page.text(token), words);
+            lengths[i] += words.size() * weight;
+            for (const std::string& word : words)
+            {
+                std::vector<Posting>& postings = index[word];
+                if (!postings.empty() && postings.back().entry == i)
+                    postings.back().frequency += weight;
+                else
+                    postings.push_back({ static_cast<uint32_t>(i), weight });
+            }
+        }
+
+        ++page_count;
+        total_length += lengths[i];
+    }
+
+    std::vector<const std::pair<const std::string, std::vector<Posting>>*> sorted;
+    sorted.reserve(index.size());
+    for (const auto& it : index)
+        sorted.push_back(&it);
+    std::sort(sorted.begin(), sorted.end(), [](const auto* a, const auto* b) { return a->first < b->first; });
+
+    std::vector<SearchTerm> terms;
+    std::string             strings, postings;
+    terms.reserve(sorted.size());
+    for (const auto* it : sorted)
+    {
+        SearchTerm term{};
+        term.str_off      = strings.size();
+        term.str_len      = it->first.size();
+        term.page_count   = it->second.size();
+        term.postings_off = postings.size();
+        strings += it->first;
+
+        uint32_t previous = 0;
+        for (const Posting& posting : it->second)
+        {
+            write_varint(postings, posting.entry - previous);
+            write_varint(postings, posting.frequency);
+            previous = posting.entry;
+        }
+
+        term.postings_len = postings.size() - term.postings_off;
+        terms.push_back(term);
+    }
+
+    SearchHeader hdr{};
+    std::memcpy(hdr.magic, SEARCH_MAGIC, sizeof(SEARCH_MAGIC));
+    hdr.version      = SEARCH_VERSION;
+    hdr.entry_count  = archive.size();
+    hdr.term_count   = terms.size();
+    hdr.page_count   = page_count;
+    hdr.total_length = total_length;
+    hdr.terms_off    = sizeof(SearchHeader);
+    hdr.lengths_off  = hdr.terms_off + terms.size() * sizeof(SearchTerm);
+    hdr.strings_off  = hdr.lengths_off + lengths.size() * sizeof(uint32_t);
+    hdr.postings_off = hdr.strings_off + strings.size();
+    hdr.file_size    = hdr.postings_off + postings.size();
+
+    const std::string& path = fmt::format("{}/{}", generation_dir, SEARCH_INDEX_NAME);
+    const std::string& tmp  = temp_path(path);
+    std::ofstream      f(tmp, std::ios::binary | std::ios::trunc);
+    f.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+    f.write(reinterpret_cast<const char*>(terms.data()), terms.size() * sizeof(SearchTerm));
+    f.write(reinterpret_cast<const char*>(lengths.data()), lengths.size() * sizeof(uint32_t));
+    f.write(strings.data(), strings.size());
+    f.write(postings.data(), postings.size());
+    f.close();
+    if (!f)
+        die("failed to write {}", tmp);
+
+    std::filesystem::rename(tmp, path);
+    return terms.size();
+}
+
+bool search_pages(const std::string_view query, const Config& config, const PageArchive& archive,
+                  const SearchIndex& index, OutputSink& out)
+{
+    struct Result
+    {
+        std::string_view command;
+        std::string_view platform;
+        size_t           rank;
+        SearchMatch      match;
+    };
+
+    // a command matches once, in the page the user would see: best language first, then the best platform
+    const std::vector<std::string>&     languages = get_languages();
+    const std::string&                  platform  = get_platform();
+    std::map<std::string_view, Result> best;
+    for (const SearchMatch& match : index.search(query))
+    {
+        const std::string_view name   = archive.name(match.entry);
+        const size_t           first  = name.find('/'), second = name.find('/', first + 1);
+        const auto&            lang   = std::find(languages.begin(), languages.end(), name.substr(0, first));
+        if (second == name.npos || lang == languages.end())
+            continue;
+
+        Result result{ name.substr(second + 1), name.substr(first + 1, second - first - 1), 0, match };
+        result.rank = (lang - languages.begin()) * 3 +
+                      (result.platform == platform ? 0 : result.platform == "common" ? 1 : 2);
+
+        const auto& [it, inserted] = best.emplace(result.command, result);
+        if (!inserted && result.rank < it->second.rank)
+            it->second = result;
+    }
+
+    // only the best ones are kept, in a heap whose top is the worst of them
+    const auto& better = [](const Result& a, const Result& b) {
+        return a.match.score != b.match.score ? a.match.score > b.match.score : a.command < b.command;
+    };
+    std::vector<Result> results;
+    results.reserve(MAX_SEARCH_RESULTS + 1);
+    for (const auto& [command, result] : best)
+    {
+        if (results.size() == MAX_SEARCH_RESULTS && !better(result, results.front()))
+            continue;
+
+        results.push_back(result);
+        std::push_heap(results.begin(), results.end(), better);
+        if (results.size() > MAX_SEARCH_RESULTS)
+        {
+            std::pop_heap(results.begin(), results.end(), better);
+            results.pop_back();
+        }
+    }
+    std::sort_heap(results.begin(), results.end(), better);
+
+    std::string  buf;
+    CompiledPage page;
+    for (const Result& result : results)
+    {
+        std::string_view description;
+        if (!archive.compiled(result.match.entry, buf, page))
+            page = CompiledPage();
+
+        for (size_t t = 0; t < page.token_count; ++t)
+        {
+            if (page.token(t).kind == TOKEN_DESCRIPTION)
+            {
+                description = page.text(page.token(t));
+                description.remove_prefix(std::min(description.find_first_not_of(' '), description.size()));
+                break;
+            }
+        }
+
+        if (!out.write(fmt::format("{}{}{}{} - {}\n", config.clr_title, result.command, NOCOLOR,
+                                   platform_tag(result.platform), description)))
+            break;
+    }
+
+    return !results.empty();
+}
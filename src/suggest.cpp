@@ -0,0 +1,253 @@
+/*
+ * Copyright 2024 Toni500git
+ * 
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ * disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "suggest.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+#include "archive.hpp"
+#include "cache.hpp"
+#include "util.hpp"
+
+// plain dynamic programming, for names too long for a 64 bits word
+static size_t edit_distance_dp(const std::string_view a, const std::string_view b)
+{
+    std::vector<size_t> row(b.size() + 1);
+    for (size_t j = 0; j <= b.size(); ++j)
+        row[j] = j;
+
+    for (size_t i = 1; i <= a.size(); ++i)
+    {
+        size_t diagonal = row[0];
+        row[0]          = i;
+        for (size_t j = 1; j <= b.size(); ++j)
+        {
+            const size_t up = row[j];
+            row[j]          = std::min({ row[j] + 1, row[j - 1] + 1, diagonal + (a[i - 1] != b[j - 1]) });
+            diagonal        = up;
+        }
+    }
+
+    return row[b.size()];
+}
+
+size_t edit_distance(std::string_view a, std::string_view b)
+{
+    // a is the pattern, whose columns are packed in the word
+    if (a.size() > b.size())
+        std::swap(a, b);
+    if (a.empty())
+        return b.size();
+    if (a.size() > 64)
+        return edit_distance_dp(a, b);
+
+    // bit i of peq[c] is set if a[i] == c
+    uint64_t peq[256] = {};
+    for (size_t i = 0; i < a.size(); ++i)
+        peq[static_cast<uint8_t>(a[i])] |= uint64_t(1) << i;
+
+    // the vertical deltas of the current column, +1 in pv and -1 in mv, and the distance in its last cell
+    const uint64_t last  = uint64_t(1) << (a.size() - 1);
+    uint64_t       pv    = ~uint64_t(0);
+    uint64_t       mv    = 0;
+    size_t         score = a.size();
+    for (const char c : b)
+    {
+        const uint64_t eq = peq[static_cast<uint8_t>(c)];
+        const uint64_t xv = eq | mv;
+        const uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+        uint64_t       ph = mv | ~(xh | pv);
+        uint64_t       mh = pv & xh;
+
+        if (ph & last)
+            ++score;
+        else if (mh & last)
+            --score;
+
+        // the first row is the distance to the empty prefix, it always grows by one
+        ph = (ph << 1) | 1;
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+    }
+
+    return score;
+}
+
+SuggestIndex::~SuggestIndex()
+{ this->close(); }
+
+void SuggestIndex::close()
+{ this->file.close(); }
+
+bool SuggestIndex::open(const std::string_view path)
+{
+    this->close();
+
+    if (!this->file.open(path, sizeof(SuggestHeader)))
+        return false;
+
+    const SuggestHeader* hdr = this->header();
+    if (!this->file.has_header(SUGGEST_MAGIC, SUGGEST_VERSION) ||
+        hdr->file_size != this->file.size() || hdr->nodes_off < sizeof(SuggestHeader) ||
+        hdr->nodes_off % alignof(SuggestNode) != 0 || hdr->edges_off % alignof(SuggestEdge) != 0 ||
+        hdr->nodes_off + hdr->node_count * sizeof(SuggestNode) > hdr->edges_off ||
+        hdr->edges_off + hdr->edge_count * sizeof(SuggestEdge) > hdr->names_off || hdr->names_off > this->file.size())
+    {
+        warn("suggestions index {} is corrupted or outdated, ignoring it", path);
+        this->close();
+        return false;
+    }
+
+    return true;
+}
+
+std::vector<std::string_view> SuggestIndex::suggest(const std::string_view command) const
+{
+    if (!this->file.data() || this->header()->node_count == 0)
+        return {};
+
+    // one typo every 4 characters, so short names don't get suggestions that have nothing in common
+    const size_t max_distance = std::clamp<size_t>(command.size() / 4, 1, 3);
+
+    const SuggestHeader*                             hdr = this->header();
+    std::vector<std::pair<size_t, std::string_view>> found;
+    std::vector<uint32_t>                            pending{ 0 };
+    for (size_t visited = 0; !pending.empty() && visited < hdr->node_count; ++visited)
+    {
+        const SuggestNode& node = this->nodes()[pending.back()];
+        pending.pop_back();
+        if (hdr->names_off + node.name_off + node.name_len > this->file.size() ||
+            uint64_t(node.first_child) + node.child_count > hdr->edge_count)
+        {
+            warn("suggestions index is corrupted");
+            return {};
+        }
+
+        const std::string_view name(this->file.data() + hdr->names_off + node.name_off, node.name_len);
+        const size_t           distance = edit_distance(command, name);
+        if (distance <= max_distance)
+            found.emplace_back(distance, name);
+
+        // only the children within max_distance of distance can be within max_distance of the command
+        const size_t       lowest = distance - std::min(distance, max_distance);
+        const SuggestEdge* begin  = this->edges() + node.first_child;
+        const SuggestEdge* end    = begin + node.child_count;
+        const SuggestEdge* it     = std::lower_bound(
+            begin, end, lowest, [](const SuggestEdge& edge, const size_t d) { return edge.distance < d; });
+        for (; it != end && it->distance <= distance + max_distance; ++it)
+            if (it->node < hdr->node_count)
+                pending.push_back(it->node);
+    }
+
+    std::sort(found.begin(), found.end());
+    std::vector<std::string_view> ret;
+    for (size_t i = 0; i < found.size() && i < MAX_SUGGESTIONS; ++i)
+        ret.push_back(found[i].second);
+
+    return ret;
+}
+
+size_t build_suggest_index(const std::string_view generation_dir)
+{
+    const std::string& archive_path = fmt::format("{}/{}", generation_dir, ARCHIVE_NAME);
+    PageArchive        archive;
+    if (!archive.open(archive_path))
+        die("failed to open {}", archive_path);
+
+    // every command once, whatever its languages and platforms
+    std::vector<std::string_view> names;
+    for (size_t i = 0; i < archive.size(); ++i)
+    {
+        const std::string_view name = archive.name(i);
+        names.push_back(name.substr(name.rfind('/') + 1));
+    }
+    std::sort(names.begin(), names.end());
+    names.erase(std::unique(names.begin(), names.end()), names.end());
+
+    // inserted in sorted order, the neighbours would be one edit apart and the tree would degenerate into long chains
+    std::sort(names.begin(), names.end(), [](const std::string_view a, const std::string_view b) {
+        return hash_bytes(a.data(), a.size()) < hash_bytes(b.data(), b.size());
+    });
+
+    std::vector<std::map<uint32_t, uint32_t>> children(names.size());
+    for (uint32_t i = 1; i < names.size(); ++i)
+    {
+        for (uint32_t node = 0;;)
+        {
+            const uint32_t distance = edit_distance(names[i], names[node]);
+            const auto& [it, inserted] = children[node].emplace(distance, i);
+            if (inserted)
+                break;
+            node = it->second;
+        }
+    }
+
+    std::vector<SuggestNode> nodes(names.size());
+    std::vector<SuggestEdge> edges;
+    std::string              strings;
+    for (size_t i = 0; i < names.size(); ++i)
+    {
+        nodes[i].name_off    = strings.size();
+        nodes[i].name_len    = names[i].size();
+        nodes[i].child_count = children[i].size();
+        nodes[i].first_child = edges.size();
+        strings += names[i];
+        for (const auto& [distance, child] : children[i])
+            edges.push_back({ distance, child });
+    }
+
+    SuggestHeader hdr{};
+    std::memcpy(hdr.magic, SUGGEST_MAGIC, sizeof(SUGGEST_MAGIC));
+    hdr.version    = SUGGEST_VERSION;
+    hdr.node_count = nodes.size();
+    hdr.edge_count = edges.size();
+    hdr.nodes_off  = sizeof(SuggestHeader);
+    hdr.edges_off  = hdr.nodes_off + nodes.size() * sizeof(SuggestNode);
+    hdr.names_off  = hdr.edges_off + edges.size() * sizeof(SuggestEdge);
+    hdr.file_size  = hdr.names_off + strings.size();
+
+    const std::string& path = fmt::format("{}/{}", generation_dir, SUGGEST_INDEX_NAME);
+    const std::string& tmp  = temp_path(path);
+    std::ofstream      f(tmp, std::ios::binary | std::ios::trunc);
+    f.write(reinterpret_cast<const char*>(&hdr), sizeof(hdr));
+    f.write(reinterpret_cast<const char*>(nodes.data()), nodes.size() * sizeof(SuggestNode));
+    f.write(reinterpret_cast<const char*>(edges.data()), edges.size() * sizeof(SuggestEdge));
+    f.write(strings.data(), strings.size());
+    f.close();
+    if (!f)
+        die("failed to write {}", tmp);
+
+    std::filesystem::rename(tmp, path);
+    return nodes.size();
+}
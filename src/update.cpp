@@ -0,0 +1,457 @@
+/*
+ * Copyright 2024 Toni500git
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ * disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "update.hpp"
+
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "archive.hpp"
+#include "cache.hpp"
+#include "color.hpp"
+#include "complete.hpp"
+#include "config.hpp"
+#include "fetch.hpp"
+#include "search.hpp"
+#include "suggest.hpp"
+#include "util.hpp"
+#include "zip.hpp"
+
+#if ONLINE
+# include "cpr/cpr.h"
+#endif
+
+static inline uint32_t rol32(const uint32_t x, const int n)
+{ return (x << n) | (x >> (32 - n)); }
+
+static void sha1_block(uint32_t h[5], const uint8_t* p)
+{
+    uint32_t w[80];
+    for (int i = 0; i < 16; ++i)
+        w[i] = (uint32_t(p[i * 4]) << 24) | (uint32_t(p[i * 4 + 1]) << 16) | (uint32_t(p[i * 4 + 2]) << 8) |
+               p[i * 4 + 3];
+    for (int i = 16; i < 80; ++i)
+        w[i] = rol32(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (int i = 0; i < 80; ++i)
+    {
+        uint32_t f, k;
+        if (i < 20)
+            f = (b & c) | (~b & d), k = 0x5a827999;
+        else if (i < 40)
+            f = b ^ c ^ d, k = 0x6ed9eba1;
+        else if (i < 60)
+            f = (b & c) | (b & d) | (c & d), k = 0x8f1bbcdc;
+        else
+            f = b ^ c ^ d, k = 0xca62c1d6;
+
+        const uint32_t tmp = rol32(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = rol32(b, 30);
+        b = a;
+        a = tmp;
+    }
+
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+}
+
+/* Hash a page the way git hashes a blob, so it can be compared with the sha of upstream tree entries
+ * @param content The page content
+ * @return the sha1 hex digest of "blob <size>\0<content>"
+ */
+std::string git_blob_sha1(const std::string_view content)
+{
+    std::string msg = fmt::format("blob {}", content.size());
+    msg += '\0';
+    msg += content;
+
+    const uint64_t bits = msg.size() * 8;
+    msg += '\x80';
+    while (msg.size() % 64 != 56)
+        msg += '\0';
+    for (int i = 7; i >= 0; --i)
+        msg += static_cast<char>(bits >> (i * 8));
+
+    uint32_t h[5] = { 0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0 };
+    for (size_t i = 0; i < msg.size(); i += 64)
+        sha1_block(h, reinterpret_cast<const uint8_t*>(msg.data() + i));
+
+    return fmt::format("{:08x}{:08x}{:08x}{:08x}{:08x}", h[0], h[1], h[2], h[3], h[4]);
+}
+
+/* The manifest of a generation has a "<sha> <path>" line for every page it was built from,
+ * the removed pages are the ones missing from it
+ */
+PageManifest read_manifest(const std::string_view path)
+{
+    PageManifest  manifest;
+    std::ifstream f(path.data());
+    std::string   line;
+    while (std::getline(f, line))
+    {
+        const size_t space = line.find(' ');
+        if (space == line.npos)
+            continue;
+
+        manifest.emplace(line.substr(space + 1), line.substr(0, space));
+    }
+
+    return manifest;
+}
+
+#if ONLINE
+/* Split the path of a page into its archive name parts
+ * @param path The page path relative to the cache or to the zip, e.g "pages.de/linux/tar.md"
+ * @return false if the path is not "pages[.language]/<platform>/<command>.md"
+ */
+static bool split_page_path(const std::string_view path, std::string& language, std::string& platform,
+                            std::string& command)
+{
+    const std::vector<std::string>& parts = split(path, '/');
+    if (parts.size() != 3 || (parts[0] != "pages" && !hasStart(parts[0], "pages.")) || parts[1].empty() ||
+        parts[2].size() <= ".md"_len || !hasEnding(parts[2], ".md"))
+        return false;
+
+    language = parts[0] == "pages" ? "en" : parts[0].substr("pages."_len);
+    platform = parts[1];
+    command  = parts[2].substr(0, parts[2].size() - ".md"_len);
+    return true;
+}
+
+static bool is_page_path(const std::string_view path)
+{
+    std::string language, platform, command;
+    return split_page_path(path, language, platform, command);
+}
+
+// "de/linux/tar" -> "pages.de/linux/tar.md"
+static std::string page_path(const std::string_view name)
+{
+    const size_t           slash    = name.find('/');
+    const std::string_view language = name.substr(0, slash);
+    return language == "en" ? fmt::format("pages{}.md", name.substr(slash))
+                            : fmt::format("pages.{}{}.md", language, name.substr(slash));
+}
+
+static void write_manifest(const std::string_view path, const PageManifest& manifest)
+{
+    std::ofstream f(path.data(), std::ios::trunc);
+    for (const auto& [page, sha] : manifest)
+        f << sha << ' ' << page << '\n';
+
+    if (!f)
+        die("failed to write {}", path);
+}
+
+/* Get the value of a string member from a flat JSON object
+ * @param obj The JSON object
+ * @param key The member name
+ * @return the unescaped value, or an empty string if there's no such string member or it has a malformed \u escape
+ */
+static std::string json_string(const std::string_view obj, const std::string_view key)
+{
+    const std::string& quoted = fmt::format("\"{}\"", key);
+    size_t             pos    = obj.find(quoted);
+    if (pos == obj.npos)
+        return {};
+
+    pos = obj.find_first_not_of(" \t\r\n", pos + quoted.size());
+    if (pos == obj.npos || obj[pos] != ':')
+        return {};
+
+    pos = obj.find_first_not_of(" \t\r\n", pos + 1);
+    if (pos == obj.npos || obj[pos] != '"')
+        return {};
+
+    std::string ret;
+    for (++pos; pos < obj.size() && obj[pos] != '"'; ++pos)
+    {
+        if (obj[pos] != '\\' || pos + 1 >= obj.size())
+        {
+            ret += obj[pos];
+            continue;
+        }
+
+        switch (obj[++pos])
+        {
+            case 'n': ret += '\n'; break;
+            case 't': ret += '\t'; break;
+            case 'r': ret += '\r'; break;
+            case 'b': ret += '\b'; break;
+            case 'f': ret += '\f'; break;
+            case 'u':
+            {
+                if (pos + 4 >= obj.size())
+                    return ret;
+
+                // a malformed escape makes the whole string unusable
+                uint32_t cp = 0;
+                for (size_t i = 1; i <= 4; ++i)
+                {
+                    const int digit = hex_digit(obj[pos + i]);
+                    if (digit < 0)
+                        return {};
+                    cp = (cp << 4) | digit;
+                }
+                pos += 4;
+                if (cp < 0x80)
+                    ret += static_cast<char>(cp);
+                else if (cp < 0x800)
+                {
+                    ret += static_cast<char>(0xc0 | (cp >> 6));
+                    ret += static_cast<char>(0x80 | (cp & 0x3f));
+                }
+                else
+                {
+                    ret += static_cast<char>(0xe0 | (cp >> 12));
+                    ret += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+                    ret += static_cast<char>(0x80 | (cp & 0x3f));
+                }
+            }
+            break;
+            default: ret += obj[pos];
+        }
+    }
+
+    return ret;
+}
+
+/* Get the pages out of a GitHub git tree (https://docs.github.com/en/rest/git/trees)
+ * @param json The tree, fetched with ?recursive=1
+ * @return the manifest of the upstream pages
+ */
+static PageManifest parse_tree(const std::string_view json)
+{
+    PageManifest manifest;
+    size_t       pos = json.find("\"tree\"");
+    if (pos == json.npos || (pos = json.find('[', pos)) == json.npos)
+        die("the pages index is not a git tree");
+
+    // the entries are flat objects, just look for the end of each one outside of strings
+    while ((pos = json.find_first_of("{]", pos)) != json.npos && json[pos] == '{')
+    {
+        bool   in_string = false;
+        size_t end       = pos + 1;
+        for (; end < json.size() && (in_string || json[end] != '}'); ++end)
+        {
+            if (json[end] == '\\')
+                ++end;
+            else if (json[end] == '"')
+                in_string = !in_string;
+        }
+
+        const std::string_view obj  = json.substr(pos, end - pos);
+        const std::string&     path = json_string(obj, "path");
+        if (json_string(obj, "type") == "blob" && is_page_path(path))
+            manifest.emplace(path, json_string(obj, "sha"));
+
+        pos = end;
+    }
+
+    if (json.find("\"truncated\":true") != json.npos)
+        warn("the pages index got truncated, some pages may be missing");
+
+    return manifest;
+}
+
+/* Stream the upstream zip straight into the new archive, decoding it while it's being downloaded,
+ * nothing touches the disk in between.
+ * The zip is a release, it may lag behind the tree the pages are compared against: only the pages matching the tree
+ * are taken, so the manifest agrees with it, and the others are left to be downloaded one by one.
+ * @param remote The manifest of the upstream tree
+ * @return the manifest of the pages taken from the zip
+ */
+static PageManifest download_all(const Config& config, const PageManifest& remote, ArchiveWriter& writer)
+{
+    PageManifest manifest;
+    std::string  language, platform, command;
+    ZipStream    zip([&](const std::string_view name, const std::string_view content) {
+        // the pages directories may be inside a top level directory
+        const std::vector<std::string>& parts = split(name, '/');
+        if (parts.size() < 3)
+            return;
+
+        const std::string& path = fmt::format("{}/{}/{}", parts[parts.size() - 3], parts[parts.size() - 2], parts.back());
+        const auto&        it   = remote.find(path);
+        if (it == remote.end() || !split_page_path(path, language, platform, command) ||
+            git_blob_sha1(content) != it->second)
+            return;
+
+        writer.add(language, platform, command, content);
+        manifest.emplace(path, it->second);
+    });
+
+    cpr::Session session;
+    session.SetUrl(cpr::Url(config.update_archive_url));
+    const cpr::Response& r = session.Download(cpr::WriteCallback(
+        [&zip](const std::string_view& data, intptr_t) -> bool { return zip.feed(data); }));
+
+    if (!zip.error().empty())
+        die("failed to decode {}: {}", config.update_archive_url, zip.error());
+    if (r.status_code != 200 || !zip.done())
+        die("failed to download {}: {} {}", config.update_archive_url, r.status_code, r.error.message);
+
+    return manifest;
+}
+
+void update_cache(const Config& config)
+{
+    std::string index;
+    long        status = 0;
+    if (!fetch_url(config.update_index_url, index, status))
+        die("failed to fetch the pages index {}: {}", config.update_index_url, status);
+
+    const PageManifest& remote = parse_tree(index);
+    if (remote.empty())
+        die("the pages index {} has no pages", config.update_index_url);
+
+    // what we have now: the manifest of the current generation, or hash the pages of its archive ourselves
+    PageManifest    local;
+    CacheGeneration current;
+    PageArchive     archive;
+    if (current.pin() && archive.open(fmt::format("{}/{}", current.path(), ARCHIVE_NAME)))
+    {
+        const std::string& manifest_path = fmt::format("{}/{}", current.path(), MANIFEST_NAME);
+        if (std::filesystem::exists(manifest_path))
+            local = read_manifest(manifest_path);
+
+        std::string buf;
+        for (size_t i = 0; local.empty() && i < archive.size(); ++i)
+            if (!archive.resolved(i))
+                local.emplace(page_path(archive.name(i)), git_blob_sha1(archive.page(i, buf)));
+    }
+
+    size_t outdated = 0;
+    for (const auto& [path, sha] : remote)
+    {
+        const auto& it = local.find(path);
+        if (it == local.end() || it->second != sha)
+            ++outdated;
+    }
+
+    size_t removed = 0;
+    for (const auto& [path, sha] : local)
+        removed += remote.find(path) == remote.end();
+
+    if (outdated + removed == 0)
+    {
+        info("the cache is already up to date");
+        return;
+    }
+
+    GenerationBuilder generation;
+    ArchiveWriter     writer(fmt::format("{}/{}", generation.path(), ARCHIVE_NAME));
+    PageManifest      manifest;
+    size_t            failed = 0;
+
+    // past a point, one big download beats a request per page
+    if (local.empty() || outdated > remote.size() / 4)
+    {
+        info("downloading all the pages from {}", config.update_archive_url);
+        manifest = download_all(config, remote, writer);
+    }
+    // keep the dictionary, so the pages that didn't change are copied without recompressing them
+    else if (archive.dictionary().size() > 0)
+        writer.set_dictionary(archive.dictionary());
+
+    // the pages the zip didn't have (or had another version of) are copied if they didn't change, or downloaded
+    cpr::Session session;
+    std::string  language, platform, command;
+    for (const auto& [path, sha] : remote)
+    {
+        if (manifest.find(path) != manifest.end())
+            continue;
+
+        split_page_path(path, language, platform, command);
+        const size_t i = archive.lookup(language, platform, command);
+        const auto&  it = local.find(path);
+        if (it != local.end() && it->second == sha && i != PageArchive::npos && !archive.resolved(i))
+        {
+            writer.copy(archive, i);
+            manifest.emplace(path, sha);
+            continue;
+        }
+
+        session.SetUrl(cpr::Url(fmt::format("{}/{}", config.update_pages_url, path)));
+        const cpr::Response& page = session.Get();
+        if (page.status_code != 200)
+        {
+            error("failed to download {}: {} {}", path, page.status_code, page.error.message);
+            // keep the old page (if any) and try again next time
+            if (it != local.end() && i != PageArchive::npos && !archive.resolved(i))
+            {
+                writer.copy(archive, i);
+                manifest.emplace(path, it->second);
+            }
+            ++failed;
+            continue;
+        }
+
+        const std::string& got = git_blob_sha1(page.text);
+        if (got != sha)
+            warn("{} doesn't match the pages index (expected {}, got {})", path, sha, got);
+
+        writer.add(language, platform, command, page.text);
+        manifest.emplace(path, got);
+    }
+
+    // counted against what we had, however the pages got here
+    size_t added = 0, changed = 0;
+    for (const auto& [path, sha] : manifest)
+    {
+        const auto& it = local.find(path);
+        if (it == local.end())
+            ++added;
+        else if (it->second != sha)
+            ++changed;
+    }
+
+    const size_t n = writer.finish();
+    write_manifest(fmt::format("{}/{}", generation.path(), MANIFEST_NAME), manifest);
+    build_search_index(generation.path());
+    build_suggest_index(generation.path());
+    build_complete_index(generation.path());
+    generation.commit();
+    // the new pages may be the ones which were missing
+    clear_misses();
+
+    info("{} pages added, {} changed, {} removed, {} failed: packed {} pages into cache generation {}", added, changed,
+         removed, failed, n, generation.id());
+}
+#else
+void update_cache(const Config& config)
+{ die("wrapup was built without ONLINE=1, it can't update the cache"); }
+#endif
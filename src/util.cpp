@@ -26,19 +26,25 @@
 #include "util.hpp"
 
 #include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
 #include <sys/stat.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
+#include <algorithm>
 #include <array>
 #include <cerrno>
+#include <cstdio>
 #include <cstring>
 #include <filesystem>
+#include <fstream>
 #include <iostream>
 #include <memory>
 #include <sstream>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <vector>
 
 #include "fmt/color.h"
@@ -72,6 +78,141 @@ std::vector<std::string> split(const std::string_view text, const char delim)
     return vec;
 }
 
+/** Read a whole file into a string with a single read()
+ * @param path The file path
+ * @param out Where to store the file content
+ * @return true if the whole file was read, else false
+ */
+bool read_file(const std::string_view path, std::string& out)
+{
+    const int fd = open(path.data(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    out.resize(st.st_size);
+    size_t done = 0;
+    while (done < out.size())
+    {
+        const ssize_t n = read(fd, out.data() + done, out.size() - done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n <= 0)
+            break;
+        done += n;
+    }
+
+    close(fd);
+    out.resize(done);
+    return done == static_cast<size_t>(st.st_size);
+}
+
+/** Get the width of the terminal a file descriptor is connected to
+ * @param fd The file descriptor
+ * @return the number of columns, or 0 if fd isn't a terminal
+ */
+size_t get_terminal_width(const int fd)
+{
+    struct winsize ws;
+    return ioctl(fd, TIOCGWINSZ, &ws) == 0 ? ws.ws_col : 0;
+}
+
+// -Wpedantic complains about __int128 otherwise
+__extension__ typedef unsigned __int128 hash_u128;
+
+static inline uint64_t hash_read8(const uint8_t* p)
+{
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t hash_read4(const uint8_t* p)
+{
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t hash_mum(const uint64_t a, const uint64_t b)
+{
+    const hash_u128 r = static_cast<hash_u128>(a) * b;
+    return static_cast<uint64_t>(r) ^ static_cast<uint64_t>(r >> 64);
+}
+
+/** Fast non-cryptographic 64bit hash (wyhash final4 construction)
+ * Used for page lookup tables and content addressing, not for anything security related.
+ * @param data The bytes to hash
+ * @param len Length of data
+ * @param seed Seed to get a different hash function from the same data
+ * @return the hash
+ */
+uint64_t hash_bytes(const void* data, const size_t len, uint64_t seed)
+{
+    constexpr uint64_t k0 = 0x2d358dccaa6c78a5ull, k1 = 0x8bb84b93962eacc9ull, k2 = 0x4b33a62ed433d4a3ull,
+                       k3 = 0x4d5a2da51de1aa47ull;
+
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    uint64_t       a, b;
+
+    seed ^= hash_mum(seed ^ k0, k1);
+    if (len <= 16)
+    {
+        if (len >= 4)
+        {
+            a = (hash_read4(p) << 32) | hash_read4(p + ((len >> 3) << 2));
+            b = (hash_read4(p + len - 4) << 32) | hash_read4(p + len - 4 - ((len >> 3) << 2));
+        }
+        else if (len > 0)
+        {
+            a = (static_cast<uint64_t>(p[0]) << 16) | (static_cast<uint64_t>(p[len >> 1]) << 8) | p[len - 1];
+            b = 0;
+        }
+        else
+            a = b = 0;
+    }
+    else
+    {
+        size_t i = len;
+        if (i > 48)
+        {
+            uint64_t see1 = seed, see2 = seed;
+            do
+            {
+                seed = hash_mum(hash_read8(p) ^ k1, hash_read8(p + 8) ^ seed);
+                see1 = hash_mum(hash_read8(p + 16) ^ k2, hash_read8(p + 24) ^ see1);
+                see2 = hash_mum(hash_read8(p + 32) ^ k3, hash_read8(p + 40) ^ see2);
+                p += 48;
+                i -= 48;
+            } while (i > 48);
+            seed ^= see1 ^ see2;
+        }
+
+        while (i > 16)
+        {
+            seed = hash_mum(hash_read8(p) ^ k1, hash_read8(p + 8) ^ seed);
+            i -= 16;
+            p += 16;
+        }
+
+        a = hash_read8(p + i - 16);
+        b = hash_read8(p + i - 8);
+    }
+
+    a ^= k1;
+    b ^= seed;
+    const hash_u128 r = static_cast<hash_u128>(a) * b;
+    a                   = static_cast<uint64_t>(r);
+    b                   = static_cast<uint64_t>(r >> 64);
+    return hash_mum(a ^ k0 ^ len, b ^ k1);
+}
+
 void ctrl_d_handler(const std::istream& cin)
 {
     if (cin.eof())
@@ -152,17 +293,6 @@ void strip(std::string& input)
     input.erase(0, input.find_first_not_of(ws));
 }
 
-fmt::rgb hexStringToColor(const std::string_view hexstr)
-{
-    std::stringstream ss;
-    ss << std::hex << hexstr.substr(1).data();
-
-    uint value;
-    ss >> value;
-
-    return fmt::rgb(value);
-}
-
 std::string get_relative_path(const std::string_view relative_path, const std::string_view _env, const long long mode)
 {
     const char *env = std::getenv(_env.data());
@@ -418,3 +548,160 @@ std::string getConfigDir()
  */
 std::string getCacheDir()
 { return getHomeCacheDir() + "/tldr"; }
+
+/** Remove the least recently used files of a cache directory until they take at most max_size bytes,
+ * the modification time of a file being its last use
+ * @param dir The cache directory
+ * @param max_size The size to get under
+ */
+void evict_least_recently_used(const std::string_view dir, const uint64_t max_size)
+{
+    namespace fs = std::filesystem;
+
+    struct Entry
+    {
+        fs::path           path;
+        uint64_t           size;
+        fs::file_time_type used;
+    };
+
+    std::vector<Entry> entries;
+    uint64_t           total = 0;
+    std::error_code    ec;
+    for (const fs::directory_entry& entry : fs::directory_iterator(dir, ec))
+    {
+        const uint64_t size = entry.file_size(ec);
+        if (ec)
+            continue;
+
+        entries.push_back({ entry.path(), size, entry.last_write_time(ec) });
+        total += size;
+    }
+
+    if (total <= max_size)
+        return;
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.used < b.used; });
+    for (const Entry& entry : entries)
+    {
+        if (total <= max_size)
+            break;
+
+        if (fs::remove(entry.path, ec))
+            total -= entry.size;
+    }
+}
+
+/** Get where to write a file before rename()ing it over path, so it's never seen half written
+ * @param path The file path
+ * @return a path next to it, unique to the calling process and thread
+ */
+std::string temp_path(const std::string_view path)
+{
+    return fmt::format("{}.{}.{:x}.tmp", path, getpid(), std::hash<std::thread::id>{}(std::this_thread::get_id()));
+}
+
+/** Replace a file with data, written to temp_path() then rename()d over it,
+ * so readers running concurrently, even in other processes, get either the old file or the new one
+ * @param path The file path, its directory gets created if needed
+ * @param data The new content
+ * @return false if it couldn't be written (nothing is left behind then)
+ */
+bool replace_file(const std::string_view path, const std::string_view data)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+
+    const std::string& tmp = temp_path(path);
+    std::ofstream      f(tmp, std::ios::binary | std::ios::trunc);
+    f.write(data.data(), data.size());
+    f.close();
+
+    if (!f || std::rename(tmp.c_str(), std::string(path).c_str()) != 0)
+    {
+        std::filesystem::remove(tmp, ec);
+        return false;
+    }
+
+    return true;
+}
+
+void write_varint(std::string& out, uint32_t value)
+{
+    while (value >= 0x80)
+    {
+        out += static_cast<char>(value | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+/** Decode a varint written by write_varint()
+ * @param data The encoded bytes
+ * @param i Where it starts, moved past it
+ * @param value Set to the decoded value
+ * @return false if it's truncated or doesn't fit in 32 bits
+ */
+bool read_varint(const std::string_view data, size_t& i, uint32_t& value)
+{
+    value = 0;
+    for (int shift = 0; shift <= 28; shift += 7)
+    {
+        if (i >= data.size())
+            return false;
+
+        const uint8_t byte = data[i++];
+        value |= uint32_t(byte & 0x7f) << shift;
+        if (!(byte & 0x80))
+            return true;
+    }
+
+    return false;
+}
+
+MappedFile::~MappedFile()
+{ this->close(); }
+
+void MappedFile::close()
+{
+    if (this->map)
+        munmap(const_cast<char*>(this->map), this->map_size);
+
+    this->map      = nullptr;
+    this->map_size = 0;
+}
+
+bool MappedFile::open(const std::string_view path, const size_t min_size)
+{
+    this->close();
+
+    const int fd = ::open(path.data(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < std::max<size_t>(min_size, 1))
+    {
+        ::close(fd);
+        return false;
+    }
+
+    void* map = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (map == MAP_FAILED)
+        return false;
+
+    this->map      = static_cast<const char*>(map);
+    this->map_size = st.st_size;
+    return true;
+}
+
+bool MappedFile::has_header(const char (&magic)[4], const uint32_t version) const
+{
+    uint32_t file_version;
+    if (this->map_size < sizeof(magic) + sizeof(file_version) || std::memcmp(this->map, magic, sizeof(magic)) != 0)
+        return false;
+
+    std::memcpy(&file_version, this->map + sizeof(magic), sizeof(file_version));
+    return file_version == version;
+}
@@ -0,0 +1,233 @@
+/*
+ * Copyright 2024 Toni500git
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ * disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include "zip.hpp"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "util.hpp"
+
+constexpr uint32_t ZIP_LOCAL_HEADER   = 0x04034b50;
+constexpr uint32_t ZIP_DESCRIPTOR     = 0x08074b50;
+constexpr uint32_t ZIP_CENTRAL_HEADER = 0x02014b50;
+constexpr uint32_t ZIP_END_OF_CENTRAL = 0x06054b50;
+
+constexpr uint16_t ZIP_FLAG_ENCRYPTED  = 1 << 0;
+constexpr uint16_t ZIP_FLAG_DESCRIPTOR = 1 << 3;
+
+constexpr uint16_t ZIP_STORED   = 0;
+constexpr uint16_t ZIP_DEFLATED = 8;
+
+constexpr size_t ZIP_LOCAL_HEADER_SIZE = 30;
+
+// zip integers are little endian
+static inline uint16_t read16(const char* p)
+{ return uint8_t(p[0]) | (uint8_t(p[1]) << 8); }
+
+static inline uint32_t read32(const char* p)
+{ return read16(p) | (uint32_t(read16(p + 2)) << 16); }
+
+ZipStream::ZipStream(Callback callback, const size_t max_file_size)
+    : callback(std::move(callback)), max_file_size(max_file_size)
+{
+    // raw deflate, zip has its own headers
+    if (inflateInit2(&this->zs, -MAX_WBITS) != Z_OK)
+        die("inflateInit2() failed");
+}
+
+ZipStream::~ZipStream()
+{ inflateEnd(&this->zs); }
+
+// @return 0, so read_*() can return fail(msg)
+size_t ZipStream::fail(const std::string_view msg)
+{
+    this->err   = msg;
+    this->state = State::ERROR;
+    return 0;
+}
+
+void ZipStream::append(const char* data, const size_t len)
+{
+    if (this->skip)
+        return;
+
+    if (this->content.size() + len > this->max_file_size)
+    {
+        debug("zip: skipping {}, it's bigger than {} bytes", this->name, this->max_file_size);
+        this->skip = true;
+        this->content.clear();
+        return;
+    }
+
+    this->content.append(data, len);
+}
+
+void ZipStream::finish_file()
+{
+    if (!this->skip)
+        this->callback(this->name, this->content);
+
+    this->state = (this->flags & ZIP_FLAG_DESCRIPTOR) ? State::DESCRIPTOR : State::HEADER;
+}
+
+// @return how many bytes of in were used, 0 if more are needed
+size_t ZipStream::read_header(const std::string_view in)
+{
+    if (in.size() < 4)
+        return 0;
+
+    const uint32_t signature = read32(in.data());
+    if (signature == ZIP_CENTRAL_HEADER || signature == ZIP_END_OF_CENTRAL)
+    {
+        this->state = State::DONE;
+        return 0;
+    }
+
+    if (signature != ZIP_LOCAL_HEADER)
+        return this->fail("invalid local file header");
+
+    if (in.size() < ZIP_LOCAL_HEADER_SIZE)
+        return 0;
+
+    const uint16_t name_len  = read16(in.data() + 26);
+    const uint16_t extra_len = read16(in.data() + 28);
+    const size_t   size      = ZIP_LOCAL_HEADER_SIZE + name_len + extra_len;
+    if (in.size() < size)
+        return 0;
+
+    this->flags     = read16(in.data() + 6);
+    this->method    = read16(in.data() + 8);
+    this->comp_size = read32(in.data() + 18);
+    this->name.assign(in.data() + ZIP_LOCAL_HEADER_SIZE, name_len);
+    this->content.clear();
+    this->consumed = 0;
+    this->skip     = hasEnding(this->name, "/");  // directories
+
+    if (this->flags & ZIP_FLAG_ENCRYPTED)
+        return this->fail(fmt::format("{} is encrypted", this->name));
+    if (this->comp_size == UINT32_MAX)
+        return this->fail("zip64 archives are not supported");
+    if (this->method == ZIP_STORED && (this->flags & ZIP_FLAG_DESCRIPTOR))
+        return this->fail(fmt::format("{} is stored with an unknown size", this->name));
+    if (this->method != ZIP_STORED && this->method != ZIP_DEFLATED)
+        return this->fail(fmt::format("{} uses an unsupported compression method {}", this->name, this->method));
+
+    if (this->method == ZIP_DEFLATED)
+        inflateReset(&this->zs);
+
+    this->state = State::DATA;
+    return size;
+}
+
+// @return how many bytes of in were used
+size_t ZipStream::read_data(const std::string_view in)
+{
+    if (this->method == ZIP_STORED)
+    {
+        const size_t len = std::min<size_t>(in.size(), this->comp_size - this->consumed);
+        this->append(in.data(), len);
+        this->consumed += len;
+        if (this->consumed == this->comp_size)
+            this->finish_file();
+        return len;
+    }
+
+    // deflate streams know where they end, so the compressed size isn't needed (it's 0 with a data descriptor)
+    char out[16384];
+    this->zs.next_in  = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+    this->zs.avail_in = in.size();
+    int ret;
+    do
+    {
+        this->zs.next_out  = reinterpret_cast<Bytef*>(out);
+        this->zs.avail_out = sizeof(out);
+        ret                = inflate(&this->zs, Z_NO_FLUSH);
+        if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR)
+            return this->fail(fmt::format("failed to inflate {}: {}", this->name, this->zs.msg ? this->zs.msg : ""));
+
+        this->append(out, sizeof(out) - this->zs.avail_out);
+    } while (ret == Z_OK && (this->zs.avail_in > 0 || this->zs.avail_out == 0));
+
+    if (ret == Z_STREAM_END)
+        this->finish_file();
+
+    return in.size() - this->zs.avail_in;
+}
+
+bool ZipStream::feed(const std::string_view data)
+{
+    if (this->state == State::ERROR)
+        return false;
+    if (this->state == State::DONE)
+        return true;
+
+    // only what can't be used yet (a split header) gets buffered
+    std::string_view in = data;
+    if (!this->buf.empty())
+    {
+        this->buf += data;
+        in = this->buf;
+    }
+
+    size_t pos = 0;
+    while (pos < in.size() && this->state != State::DONE && this->state != State::ERROR)
+    {
+        const std::string_view rest   = in.substr(pos);
+        const State            before = this->state;
+        size_t                 used   = 0;
+        switch (this->state)
+        {
+            case State::HEADER: used = this->read_header(rest); break;
+            case State::DATA:   used = this->read_data(rest); break;
+            case State::DESCRIPTOR:
+                // the signature is optional
+                if (rest.size() < 16)
+                    break;
+                used        = read32(rest.data()) == ZIP_DESCRIPTOR ? 16 : 12;
+                this->state = State::HEADER;
+                break;
+            default: break;
+        }
+
+        // waiting for more bytes
+        if (used == 0 && this->state == before)
+            break;
+
+        pos += used;
+    }
+
+    if (this->state == State::ERROR)
+        return false;
+
+    this->buf = std::string(in.substr(pos));
+    return true;
+}
@@ -0,0 +1,126 @@
+/*
+ * Copyright 2024 Toni500git
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ * disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided with the distribution.
+ *
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _TEST_HPP
+#define _TEST_HPP
+
+#include <stdlib.h>
+
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "fmt/core.h"
+
+/* A test is a function registered with TEST(name), which fails if one of its CHECK()s does.
+ * tests/main.cpp runs them all, or only the ones whose name contains its first argument.
+ */
+struct TestCase
+{
+    const char*           name;
+    std::function<void()> run;
+};
+
+inline std::vector<TestCase>& test_cases()
+{
+    static std::vector<TestCase> cases;
+    return cases;
+}
+
+inline size_t& test_failures()
+{
+    static size_t failures = 0;
+    return failures;
+}
+
+inline bool register_test(const char* name, std::function<void()> run)
+{
+    test_cases().push_back({ name, std::move(run) });
+    return true;
+}
+
+#define TEST(name)                                                            \
+    static void       name();                                                 \
+    static const bool name##_registered = register_test(#name, name);        \
+    static void       name()
+
+// variadic so conditions with commas (templates, braced lists) don't need extra parentheses
+#define CHECK(...)                                                                            \
+    do                                                                                        \
+    {                                                                                         \
+        if (!(__VA_ARGS__))                                                                   \
+        {                                                                                     \
+            fmt::print(stderr, "{}:{}: CHECK({}) failed\n", __FILE__, __LINE__, #__VA_ARGS__); \
+            ++test_failures();                                                                \
+        }                                                                                     \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                                                  \
+    do                                                                                                  \
+    {                                                                                                   \
+        const auto& _a = (a);                                                                           \
+        const auto& _b = (b);                                                                           \
+        if (!(_a == _b))                                                                                \
+        {                                                                                               \
+            fmt::print(stderr, "{}:{}: CHECK_EQ({}, {}) failed: {} != {}\n", __FILE__, __LINE__, #a, #b, \
+                       _a, _b);                                                                         \
+            ++test_failures();                                                                          \
+        }                                                                                               \
+    } while (0)
+
+// A directory removed with everything in it when it goes out of scope
+class TempDir
+{
+public:
+    TempDir()
+    {
+        std::string tmpl = (std::filesystem::temp_directory_path() / "wrapup-test-XXXXXX").string();
+        if (!mkdtemp(tmpl.data()))
+            throw std::runtime_error("mkdtemp failed");
+        this->dir = tmpl;
+    }
+
+    ~TempDir()
+    {
+        std::error_code ec;
+        std::filesystem::remove_all(this->dir, ec);
+    }
+
+    TempDir(const TempDir&)            = delete;
+    TempDir& operator=(const TempDir&) = delete;
+
+    const std::string& path() const
+    { return this->dir; }
+
+    std::string operator/(const std::string_view name) const
+    { return fmt::format("{}/{}", this->dir, name); }
+
+private:
+    std::string dir;
+};
+
+#endif  // !_TEST_HPP
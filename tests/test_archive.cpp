@@ -0,0 +1,237 @@
+/*
+ * Copyright 2024 Toni500git
+ * 
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ * disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <cstddef>
+#include <fstream>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "archive.hpp"
+#include "util.hpp"
+#include "test.hpp"
+
+static std::string make_page(const std::string_view command, const std::string_view description)
+{
+    return fmt::format("# {}\n\n> {}\n\n- Run it:\n\n`{} {{{{path/to/file}}}}`\n", command, description, command);
+}
+
+TEST(archive_round_trip)
+{
+    TempDir            dir;
+    const std::string& path = dir / "pages.pack";
+
+    std::map<std::string, std::string> pages = {
+        { "en/common/tar", make_page("tar", "Archiving utility.") },
+        { "en/linux/ls", make_page("ls", "List directory contents.") },
+        { "en/osx/ls", make_page("ls", "List directory contents, the BSD way.") },
+        { "de/common/tar", make_page("tar", "Archivierungswerkzeug.") },
+    };
+    {
+        ArchiveWriter writer(path);
+        for (const auto& [name, content] : pages)
+        {
+            const std::vector<std::string>& parts = split(name, '/');
+            writer.add(parts[0], parts[1], parts[2], content);
+        }
+        writer.finish();
+    }
+
+    PageArchive archive;
+    CHECK(archive.open(path));
+
+    std::string buf;
+    for (const auto& [name, content] : pages)
+    {
+        const std::vector<std::string>& parts = split(name, '/');
+        const size_t                    i     = archive.lookup(parts[0], parts[1], parts[2]);
+        CHECK(i != PageArchive::npos);
+        CHECK(!archive.resolved(i));
+        CHECK_EQ(archive.name(i), name);
+        CHECK_EQ(archive.page(i, buf), content);
+    }
+
+    // missing from the platform: common first, then the other platforms
+    CHECK_EQ(archive.find("en", "linux", "tar", buf), pages["en/common/tar"]);
+    CHECK(archive.resolved(archive.lookup("en", "linux", "tar")));
+    CHECK_EQ(archive.find("en", "common", "ls", buf).empty(), false);
+
+    CHECK(archive.lookup("en", "linux", "nope") == PageArchive::npos);
+    CHECK(archive.lookup("fr", "common", "tar") == PageArchive::npos);
+}
+
+TEST(archive_dedup)
+{
+    TempDir            dir;
+    const std::string& path = dir / "pages.pack";
+    const std::string& same = make_page("cat", "Print files.");
+    {
+        ArchiveWriter writer(path);
+        writer.add("en", "linux", "cat", same);
+        writer.add("en", "osx", "cat", same);
+        writer.add("en", "linux", "dog", make_page("dog", "Not cat."));
+        writer.finish();
+    }
+
+    PageArchive archive;
+    CHECK(archive.open(path));
+    const size_t a = archive.lookup("en", "linux", "cat"), b = archive.lookup("en", "osx", "cat");
+    CHECK(a != PageArchive::npos && b != PageArchive::npos);
+    CHECK_EQ(archive.content_hash(a), archive.content_hash(b));
+
+    std::string buf;
+    CHECK_EQ(archive.page(b, buf), same);
+    CHECK_EQ(archive.find("en", "linux", "dog", buf), make_page("dog", "Not cat."));
+}
+
+TEST(archive_copy)
+{
+    TempDir dir;
+    {
+        ArchiveWriter writer(dir / "old.pack");
+        writer.add("en", "common", "a", make_page("a", "First."));
+        writer.add("en", "common", "b", make_page("b", "Second."));
+        writer.finish();
+    }
+
+    PageArchive old;
+    CHECK(old.open(dir / "old.pack"));
+    {
+        ArchiveWriter writer(dir / "new.pack");
+        writer.set_dictionary(old.dictionary());
+        writer.copy(old, old.lookup("en", "common", "a"));
+        writer.add("en", "common", "b", make_page("b", "Changed."));
+        writer.finish();
+    }
+
+    PageArchive archive;
+    std::string buf;
+    CHECK(archive.open(dir / "new.pack"));
+    CHECK_EQ(archive.find("en", "common", "a", buf), make_page("a", "First."));
+    CHECK_EQ(archive.find("en", "common", "b", buf), make_page("b", "Changed."));
+}
+
+// pages sharing their content hash but not their bytes don't get deduplicated
+TEST(archive_hash_collision)
+{
+    TempDir dir;
+    {
+        ArchiveWriter writer(dir / "old.pack");
+        writer.add("en", "common", "a", make_page("a", "First."));
+        writer.add("en", "common", "b", make_page("b", "Second."));
+        writer.finish();
+    }
+
+    // forge the collision: b gets the hash of a
+    {
+        PageArchive old;
+        CHECK(old.open(dir / "old.pack"));
+        const size_t a = old.lookup("en", "common", "a"), b = old.lookup("en", "common", "b");
+        const uint64_t hash = old.content_hash(a);
+
+        std::fstream  f(dir / "old.pack", std::ios::in | std::ios::out | std::ios::binary);
+        ArchiveHeader hdr;
+        f.read(reinterpret_cast<char*>(&hdr), sizeof(hdr));
+        f.seekp(hdr.entries_off + b * sizeof(ArchiveEntry) + offsetof(ArchiveEntry, content_hash));
+        f.write(reinterpret_cast<const char*>(&hash), sizeof(hash));
+    }
+
+    PageArchive old;
+    CHECK(old.open(dir / "old.pack"));
+    CHECK_EQ(old.content_hash(old.lookup("en", "common", "a")), old.content_hash(old.lookup("en", "common", "b")));
+
+    // with the blobs still held back for the dictionary, then with them already written
+    for (const bool dictionary : { false, true })
+    {
+        {
+            ArchiveWriter writer(dir / "new.pack");
+            if (dictionary)
+                writer.set_dictionary(old.dictionary());
+            writer.copy(old, old.lookup("en", "common", "a"));
+            writer.copy(old, old.lookup("en", "common", "b"));
+            writer.finish();
+        }
+
+        PageArchive archive;
+        std::string buf;
+        CHECK(archive.open(dir / "new.pack"));
+        CHECK_EQ(archive.find("en", "common", "a", buf), make_page("a", "First."));
+        CHECK_EQ(archive.find("en", "common", "b", buf), make_page("b", "Second."));
+    }
+}
+
+// enough pages to train a dictionary and to exercise the perfect hash
+TEST(archive_many_pages)
+{
+    TempDir            dir;
+    const std::string& path = dir / "pages.pack";
+    constexpr size_t   n    = 50000;
+
+    std::mt19937             rng(42);
+    std::vector<std::string> commands;
+    {
+        ArchiveWriter writer(path);
+        for (size_t i = 0; i < n; ++i)
+        {
+            commands.push_back(fmt::format("cmd{}-{}", i, rng() % 1000));
+            writer.add("en", "common", commands.back(), make_page(commands.back(), fmt::format("Command {}.", i)));
+        }
+        CHECK_EQ(writer.finish(), n);
+    }
+
+    PageArchive archive;
+    CHECK(archive.open(path));
+    CHECK(archive.dictionary().size() > 0);
+
+    std::string buf;
+    size_t      found = 0;
+    for (const std::string& command : commands)
+    {
+        const size_t i = archive.lookup("en", "common", command);
+        found += i != PageArchive::npos && archive.name(i) == fmt::format("en/common/{}", command);
+    }
+    CHECK_EQ(found, n);
+    CHECK_EQ(archive.find("en", "common", commands[1234], buf), make_page(commands[1234], "Command 1234."));
+
+    size_t misses = 0;
+    for (size_t i = 0; i < 1000; ++i)
+        misses += archive.lookup("en", "common", fmt::format("missing{}", i)) == PageArchive::npos;
+    CHECK_EQ(misses, 1000u);
+}
+
+TEST(archive_rejects_garbage)
+{
+    TempDir dir;
+    {
+        std::ofstream f(dir / "bad.pack", std::ios::binary);
+        f << std::string(512, 'x');
+    }
+
+    PageArchive archive;
+    CHECK(!archive.open(dir / "bad.pack"));
+    CHECK(!archive.open(dir / "missing.pack"));
+    CHECK_EQ(archive.size(), 0u);
+}
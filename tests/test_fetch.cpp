@@ -0,0 +1,64 @@
+/*
+ * Copyright 2024 Toni500git
+ * 
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ * disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+
+#include "fetch.hpp"
+#include "test.hpp"
+#include "util.hpp"
+
+// several processes remembering misses at once don't lose any of them
+TEST(misses_from_several_processes)
+{
+    TempDir dir;
+    setenv("XDG_CACHE_HOME", dir.path().c_str(), 1);
+    std::filesystem::create_directories(getCacheDir());
+
+    constexpr int processes = 4, urls = 50;
+    for (int p = 0; p < processes; ++p)
+    {
+        if (fork() != 0)
+            continue;
+        for (int i = 0; i < urls; ++i)
+            remember_miss(fmt::format("https://example.com/{}/{}", p, i));
+        _exit(0);
+    }
+    for (int p = 0; p < processes; ++p)
+        wait(nullptr);
+
+    size_t missing = 0;
+    for (int p = 0; p < processes; ++p)
+        for (int i = 0; i < urls; ++i)
+            missing += !is_known_miss(fmt::format("https://example.com/{}/{}", p, i));
+    CHECK_EQ(missing, 0u);
+    CHECK(!is_known_miss("https://example.com/other"));
+
+    clear_misses();
+    CHECK(!is_known_miss("https://example.com/0/0"));
+}
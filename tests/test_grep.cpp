@@ -0,0 +1,56 @@
+/*
+ * Copyright 2024 Toni500git
+ * 
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ * disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include <string>
+
+#include "grep.hpp"
+#include "parse.hpp"
+#include "test.hpp"
+
+TEST(required_literal_top_level)
+{
+    CHECK_EQ(required_literal("tar -xvf"), "tar -xvf");
+    CHECK_EQ(required_literal("git (add|commit) --amend"), " --amend");
+    CHECK_EQ(required_literal("docker|podman"), "");
+    CHECK_EQ(required_literal("colou?r"), "colo");
+    CHECK_EQ(required_literal("[a-z]+ --force"), " --force");
+    CHECK_EQ(required_literal("a\\.b"), "a.b");
+}
+
+// the operands of \x, \u and \c aren't part of the literal
+TEST(required_literal_escapes)
+{
+    CHECK_EQ(required_literal("\\x2dexec"), "exec");
+    CHECK_EQ(required_literal("\\u002dexec"), "exec");
+    CHECK_EQ(required_literal("\\cJfind"), "find");
+    CHECK_EQ(required_literal("\\d+ seconds"), " seconds");
+}
+
+// only the pages of another platform get flagged in grep and search results
+TEST(platform_tag_foreign_only)
+{
+    CHECK_EQ(platform_tag("common"), "");
+    CHECK_EQ(platform_tag(get_platform()), "");
+    CHECK_EQ(platform_tag("not-a-platform"), " (not-a-platform)");
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright 2024 Toni500git
+ * 
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ * disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "archive.hpp"
+#include "cache.hpp"
+#include "complete.hpp"
+#include "parse.hpp"
+#include "search.hpp"
+#include "suggest.hpp"
+#include "test.hpp"
+
+// write an archive of pages ("platform/command" -> markdown) where the indexes expect it
+static void write_archive(const TempDir& dir, const std::vector<std::pair<std::string, std::string>>& pages)
+{
+    ArchiveWriter writer(dir / ARCHIVE_NAME);
+    for (const auto& [name, content] : pages)
+        writer.add("en", name.substr(0, name.find('/')), name.substr(name.find('/') + 1), content);
+    writer.finish();
+}
+
+static size_t edit_distance_reference(const std::string_view a, const std::string_view b)
+{
+    std::vector<std::vector<size_t>> d(a.size() + 1, std::vector<size_t>(b.size() + 1));
+    for (size_t i = 0; i <= a.size(); ++i)
+        d[i][0] = i;
+    for (size_t j = 0; j <= b.size(); ++j)
+        d[0][j] = j;
+    for (size_t i = 1; i <= a.size(); ++i)
+        for (size_t j = 1; j <= b.size(); ++j)
+            d[i][j] = std::min({ d[i - 1][j] + 1, d[i][j - 1] + 1, d[i - 1][j - 1] + (a[i - 1] != b[j - 1]) });
+    return d[a.size()][b.size()];
+}
+
+TEST(edit_distance_matches_reference)
+{
+    std::mt19937 rng(5);
+    size_t       wrong = 0;
+    for (size_t round = 0; round < 20000; ++round)
+    {
+        // past 64 characters it falls back to the plain dynamic programming
+        std::string a(rng() % 80, ' '), b(rng() % 80, ' ');
+        for (char& c : a)
+            c = 'a' + rng() % 4;
+        for (char& c : b)
+            c = 'a' + rng() % 4;
+        wrong += edit_distance(a, b) != edit_distance_reference(a, b);
+    }
+    CHECK_EQ(wrong, 0u);
+    CHECK_EQ(edit_distance("kitten", "sitting"), 3u);
+    CHECK_EQ(edit_distance("", "abc"), 3u);
+}
+
+TEST(suggest_index)
+{
+    TempDir dir;
+    write_archive(dir, { { "common/git", "# git\n" },
+                         { "common/grep", "# grep\n" },
+                         { "common/tar", "# tar\n" },
+                         { "linux/systemctl", "# systemctl\n" },
+                         { "common/docker", "# docker\n" } });
+    CHECK_EQ(build_suggest_index(dir.path()), 5u);
+
+    SuggestIndex index;
+    CHECK(index.open(dir / SUGGEST_INDEX_NAME));
+    CHECK(index.suggest("systemclt") == std::vector<std::string_view>{ "systemctl" });
+    CHECK(index.suggest("dockr") == std::vector<std::string_view>{ "docker" });
+    CHECK(index.suggest("gitt") == std::vector<std::string_view>{ "git" });
+    CHECK(index.suggest("zzzzzzzz").empty());
+}
+
+TEST(complete_index)
+{
+    TempDir dir;
+    write_archive(dir, { { "common/git", "# git\n" },
+                         { "common/git-log", "# git log\n" },
+                         { "common/grep", "# grep\n" },
+                         { get_platform() + "/gitk", "# gitk\n" },
+                         { "sunos-or-else/gitx", "# gitx\n" } });
+    build_complete_index(dir.path());
+
+    CompleteIndex index;
+    CHECK(index.open(dir / COMPLETE_INDEX_NAME));
+
+    // the current platform has every command, the others resolved into it
+    std::vector<std::string> commands;
+    CHECK(index.complete("en", "git", commands));
+    CHECK(commands == std::vector<std::string>{ "git", "git-log", "gitk", "gitx" });
+
+    commands.clear();
+    CHECK(index.complete("en", "", commands));
+    CHECK_EQ(commands.size(), 5u);
+
+    commands.clear();
+    CHECK(index.complete("de", "g", commands));
+    CHECK(commands.empty());
+}
+
+TEST(search_ranking)
+{
+    TempDir dir;
+    write_archive(dir, {
+        { "common/gzip", "# gzip\n\n> Compress files.\n\n- Compress a file:\n\n`gzip {{file}}`\n" },
+        { "common/tar", "# tar\n\n> Archiving utility.\n\n- Create an archive and compress it:\n\n`tar czf a.tgz`\n" },
+        { "common/compress", "# compress\n\n> Compress files with LZW.\n\n- Compress:\n\n`compress {{file}}`\n" },
+        { "common/ls", "# ls\n\n> List directory contents.\n" },
+    });
+    build_search_index(dir.path());
+
+    PageArchive archive;
+    SearchIndex index;
+    CHECK(archive.open(dir / ARCHIVE_NAME));
+    CHECK(index.open(dir / SEARCH_INDEX_NAME, archive));
+
+    std::vector<SearchMatch> matches = index.search("compress");
+    std::sort(matches.begin(), matches.end(),
+              [](const SearchMatch& a, const SearchMatch& b) { return a.score > b.score; });
+    CHECK_EQ(matches.size(), 3u);
+
+    // the title counts the most, then the description, then the examples
+    std::vector<std::string_view> names;
+    for (const SearchMatch& match : matches)
+        names.push_back(archive.name(match.entry));
+    CHECK(names == std::vector<std::string_view>{ "en/common/compress", "en/common/gzip", "en/common/tar" });
+
+    // every word has to be there
+    CHECK_EQ(index.search("compress archive").size(), 1u);
+    CHECK(index.search("nothing").empty());
+    CHECK(index.search("list directory").size() == 1);
+}
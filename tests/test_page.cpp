@@ -0,0 +1,135 @@
+/*
+ * Copyright 2024 Toni500git
+ * 
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ * disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <random>
+#include <string>
+#include <vector>
+
+#include "page.hpp"
+#include "render.hpp"
+#include "test.hpp"
+#include "util.hpp"
+
+// the markers as the scanners should find them, one byte at a time
+static std::vector<uint32_t> scan_markers_reference(const std::string_view data)
+{
+    std::vector<uint32_t> offsets;
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        if (data[i] == '`' || (i + 1 < data.size() && ((data[i] == '{' && data[i + 1] == '{') ||
+                                                       (data[i] == '}' && data[i + 1] == '}'))))
+            offsets.push_back(i);
+    }
+    return offsets;
+}
+
+TEST(scan_markers_matches_reference)
+{
+    std::mt19937 rng(1);
+    const char   alphabet[] = "`{}ab \n";
+    for (size_t round = 0; round < 2000; ++round)
+    {
+        // every length around the vector widths, so the tails and the 32/64 bytes boundaries get hit
+        std::string text(rng() % 200, ' ');
+        for (char& c : text)
+            c = alphabet[rng() % (sizeof(alphabet) - 1)];
+
+        std::vector<uint32_t> offsets;
+        scan_markers(text, offsets);
+        CHECK(offsets == scan_markers_reference(text));
+    }
+}
+
+TEST(compile_page_tokens)
+{
+    const std::string_view md = "# tar\n\n> Archiver.\n\n- Extract:\n\n`tar xf {{file}} {{{{x}}}}`\n";
+    std::string            stored;
+    CompiledPage           page;
+    compile_page(md, stored);
+    CHECK(read_compiled_page(stored, page));
+    CHECK_EQ(page.markdown, md);
+
+    std::vector<std::pair<uint8_t, std::string_view>> tokens;
+    for (size_t i = 0; i < page.token_count; ++i)
+        tokens.emplace_back(page.token(i).kind, page.text(page.token(i)));
+
+    CHECK(tokens.size() >= 6);
+    CHECK(tokens[0] == std::make_pair<uint8_t, std::string_view>(TOKEN_TITLE, " tar"));
+    CHECK(tokens[1] == std::make_pair<uint8_t, std::string_view>(TOKEN_DESCRIPTION, " Archiver."));
+    CHECK(tokens[2] == std::make_pair<uint8_t, std::string_view>(TOKEN_EXAMPLE, "Extract:"));
+    CHECK(tokens[3] == std::make_pair<uint8_t, std::string_view>(TOKEN_CODE, "tar xf "));
+    CHECK(tokens[4] == std::make_pair<uint8_t, std::string_view>(TOKEN_PLACEHOLDER, "file"));
+
+    // truncated pages are rejected
+    CHECK(!read_compiled_page(std::string_view(stored).substr(0, stored.size() - 1), page));
+}
+
+// columns a rendered row takes, escapes skipped and tabs expanded, and the column of its first word (after the '-' of examples)
+static size_t visible_width(const std::string_view row, size_t& first_word)
+{
+    size_t col = 0;
+    first_word = std::string::npos;
+    for (size_t i = 0; i < row.size(); ++i)
+    {
+        if (row[i] == '\033')
+            while (i < row.size() && row[i] != 'm')
+                ++i;
+        else if (row[i] == '\t')
+            col = (col / 8 + 1) * 8;
+        else
+        {
+            if (row[i] != ' ' && row[i] != '-' && first_word == std::string::npos)
+                first_word = col;
+            ++col;
+        }
+    }
+    return col;
+}
+
+TEST(wrap_lines_up_with_first_word)
+{
+    const std::string words = "a description long enough to be wrapped over a few rows at this width";
+    // the first word is in column 3 for the title and the description, as the token keeps the space after the marker
+    const std::vector<std::pair<std::string, size_t>> lines = {
+        { "  \033[1m tar " + words, 3 },
+        { "  \033[34m " + words, 3 },
+        { "  -\033[36m " + words, 4 },
+        { "  \t\033[33mtar " + words, 8 },
+    };
+
+    std::string wrapped;
+    for (const auto& [line, column] : lines)
+    {
+        wrap_rendered_line(line, 24, wrapped);
+        const std::vector<std::string>& rows = split(wrapped, '\n');
+        CHECK(rows.size() > 2);
+        for (const std::string& row : rows)
+        {
+            size_t first_word;
+            CHECK(visible_width(row, first_word) <= 24);
+            CHECK_EQ(first_word, column);
+        }
+    }
+}
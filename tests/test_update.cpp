@@ -0,0 +1,263 @@
+/*
+ * Copyright 2024 Toni500git
+ * 
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ * disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+// the update talks HTTP, so it's only built with ONLINE=1
+#if ONLINE
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "archive.hpp"
+#include "cache.hpp"
+#include "config.hpp"
+#include "test.hpp"
+#include "update.hpp"
+#include "zip_writer.hpp"
+
+/* A local stand-in for GitHub, serving fixed bodies by path on 127.0.0.1, one request per connection.
+ * It counts the requests, to check which pages an update downloaded.
+ */
+class HttpServer
+{
+public:
+    HttpServer()
+    {
+        this->fd = socket(AF_INET, SOCK_STREAM, 0);
+        struct sockaddr_in addr{};
+        addr.sin_family      = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t len        = sizeof(addr);
+        if (bind(this->fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(this->fd, 16) != 0 ||
+            getsockname(this->fd, reinterpret_cast<sockaddr*>(&addr), &len) != 0)
+            throw std::runtime_error("can't listen on 127.0.0.1");
+
+        this->port   = ntohs(addr.sin_port);
+        this->thread = std::thread([this]() { this->serve(); });
+    }
+
+    ~HttpServer()
+    {
+        // makes accept() fail, which ends serve()
+        shutdown(this->fd, SHUT_RDWR);
+        this->thread.join();
+        close(this->fd);
+    }
+
+    std::string url(const std::string_view path) const
+    { return fmt::format("http://127.0.0.1:{}{}", this->port, path); }
+
+    void set(const std::string& path, const std::string& body)
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->routes[path] = body;
+    }
+
+    size_t hits(const std::string& path)
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        return this->requests[path];
+    }
+
+    // requests since the last call, to any path
+    size_t total()
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        size_t n = 0;
+        for (const auto& [path, count] : this->requests)
+            n += count;
+        return n - std::exchange(this->counted, n);
+    }
+
+private:
+    void serve()
+    {
+        for (int client; (client = accept(this->fd, nullptr, nullptr)) >= 0; close(client))
+        {
+            std::string request;
+            char        buf[4096];
+            ssize_t     n;
+            while (request.find("\r\n\r\n") == request.npos && (n = read(client, buf, sizeof(buf))) > 0)
+                request.append(buf, n);
+
+            const size_t       begin = request.find(' ') + 1;
+            const std::string& path  = request.substr(begin, request.find(' ', begin) - begin);
+
+            std::string response;
+            {
+                std::lock_guard<std::mutex> lock(this->mutex);
+                ++this->requests[path];
+                const auto& it = this->routes.find(path);
+                response       = it == this->routes.end()
+                                     ? "HTTP/1.1 404 Not Found\r\nContent-Length: 0\r\nConnection: close\r\n\r\n"
+                                     : fmt::format("HTTP/1.1 200 OK\r\nContent-Length: {}\r\nConnection: close\r\n\r\n{}",
+                                                   it->second.size(), it->second);
+            }
+
+            for (size_t done = 0; done < response.size() && (n = write(client, response.data() + done,
+                                                                       response.size() - done)) > 0;)
+                done += n;
+        }
+    }
+
+    int                                fd;
+    uint16_t                           port;
+    std::thread                        thread;
+    std::mutex                         mutex;
+    std::map<std::string, std::string> routes;
+    std::map<std::string, size_t>      requests;
+    size_t                             counted = 0;
+};
+
+static std::string page(const std::string_view name, const std::string_view description)
+{ return fmt::format("# {}\n\n> {}.\n\n- Run it:\n\n`{} {{{{file}}}}`\n", name, description, name); }
+
+// a GitHub git tree of the pages, as fetched with ?recursive=1
+static std::string tree_json(const std::map<std::string, std::string>& pages)
+{
+    std::string json = "{\"sha\":\"0\",\"tree\":[{\"path\":\"pages\",\"mode\":\"040000\",\"type\":\"tree\",\"sha\":\"0\"}";
+    for (const auto& [path, content] : pages)
+        json += fmt::format(",{{\"path\":\"{}\",\"mode\":\"100644\",\"type\":\"blob\",\"sha\":\"{}\",\"size\":{}}}",
+                            path, git_blob_sha1(content), content.size());
+    return json + "],\"truncated\":false}";
+}
+
+static PageManifest tree_manifest(const std::map<std::string, std::string>& pages)
+{
+    PageManifest manifest;
+    for (const auto& [path, content] : pages)
+        manifest.emplace(path, git_blob_sha1(content));
+    return manifest;
+}
+
+// the content of a page in the current generation, empty if it's not there
+static std::string cached_page(const std::string_view command)
+{
+    CacheGeneration generation;
+    PageArchive     archive;
+    std::string     buf;
+    if (!generation.pin() || !archive.open(fmt::format("{}/{}", generation.path(), ARCHIVE_NAME)))
+        return {};
+    const size_t i = archive.lookup("en", "common", command);
+    return i == PageArchive::npos ? std::string() : std::string(archive.page(i, buf));
+}
+
+static PageManifest cached_manifest()
+{
+    CacheGeneration generation;
+    return generation.pin() ? read_manifest(fmt::format("{}/{}", generation.path(), MANIFEST_NAME)) : PageManifest();
+}
+
+TEST(update_from_local_server)
+{
+    TempDir    dir;
+    HttpServer server;
+    setenv("XDG_CACHE_HOME", dir.path().c_str(), 1);
+
+    std::ofstream(dir / "config.toml") << fmt::format(
+        "[update]\nindex-url = \"{}\"\npages-url = \"{}\"\narchive-url = \"{}\"\n", server.url("/tree"),
+        server.url("/raw"), server.url("/tldr.zip"));
+    const Config config(dir / "config.toml", dir.path());
+
+    std::map<std::string, std::string> pages;
+    for (size_t i = 0; i < 12; ++i)
+        pages[fmt::format("pages/common/cmd{}.md", i)] = page(fmt::format("cmd{}", i), fmt::format("Command {}", i));
+
+    // the release zip lags behind the tree: cmd5 changed since, and cmd11 is new
+    std::map<std::string, std::string> release(pages);
+    release.erase("pages/common/cmd11.md");
+    release["pages/common/cmd5.md"] = page("cmd5", "An older description");
+
+    server.set("/tree", tree_json(pages));
+    server.set("/tldr.zip", make_zip(release, true));
+    for (const auto& [path, content] : pages)
+        server.set("/raw/" + path, content);
+
+    // the first update takes the zip, and downloads what it's missing or has another version of
+    update_cache(config);
+    CHECK(cached_manifest() == tree_manifest(pages));
+    CHECK_EQ(cached_page("cmd5"), pages["pages/common/cmd5.md"]);
+    CHECK_EQ(cached_page("cmd11"), pages["pages/common/cmd11.md"]);
+    CHECK_EQ(server.hits("/tldr.zip"), 1u);
+    CHECK_EQ(server.hits("/raw/pages/common/cmd5.md"), 1u);
+    CHECK_EQ(server.hits("/raw/pages/common/cmd11.md"), 1u);
+    CHECK_EQ(server.total(), 4u);
+
+    // nothing changed upstream, only the tree gets fetched
+    update_cache(config);
+    CHECK_EQ(server.total(), 1u);
+
+    // one page changed, one added and one removed: only those two are downloaded
+    pages["pages/common/cmd3.md"]  = page("cmd3", "A new description");
+    pages["pages/common/cmd12.md"] = page("cmd12", "Command 12");
+    pages.erase("pages/common/cmd0.md");
+    server.set("/tree", tree_json(pages));
+    server.set("/raw/pages/common/cmd3.md", pages["pages/common/cmd3.md"]);
+    server.set("/raw/pages/common/cmd12.md", pages["pages/common/cmd12.md"]);
+
+    update_cache(config);
+    CHECK(cached_manifest() == tree_manifest(pages));
+    CHECK_EQ(cached_page("cmd3"), pages["pages/common/cmd3.md"]);
+    CHECK_EQ(cached_page("cmd12"), pages["pages/common/cmd12.md"]);
+    CHECK_EQ(cached_page("cmd0"), "");
+    CHECK_EQ(cached_page("cmd7"), pages["pages/common/cmd7.md"]);
+    CHECK_EQ(server.hits("/tldr.zip"), 1u);
+    CHECK_EQ(server.hits("/raw/pages/common/cmd3.md"), 1u);
+    CHECK_EQ(server.total(), 3u);
+}
+
+// a malformed \u escape in the tree only drops the entry it's in, a valid one gets decoded
+TEST(update_tree_with_escapes)
+{
+    TempDir    dir;
+    HttpServer server;
+    setenv("XDG_CACHE_HOME", dir.path().c_str(), 1);
+
+    std::ofstream(dir / "config.toml") << fmt::format(
+        "[update]\nindex-url = \"{}\"\npages-url = \"{}\"\narchive-url = \"{}\"\n", server.url("/tree"),
+        server.url("/raw"), server.url("/tldr.zip"));
+    const Config config(dir / "config.toml", dir.path());
+
+    const std::map<std::string, std::string> pages = { { "pages/common/abc.md", page("abc", "Escaped") },
+                                                       { "pages/common/tar.md", page("tar", "Archiver") } };
+    std::string tree = tree_json(pages);
+    tree.replace(tree.find("abc.md"), "a"_len, "\\u0061");
+    tree.insert(tree.size() - "],\"truncated\":false}"_len,
+                ",{\"path\":\"pages/common/bad\\uzzzz.md\",\"mode\":\"100644\",\"type\":\"blob\",\"sha\":\"0\"}");
+
+    server.set("/tree", tree);
+    server.set("/tldr.zip", make_zip(pages, false));
+    update_cache(config);
+    CHECK(cached_manifest() == tree_manifest(pages));
+    CHECK_EQ(cached_page("abc"), pages.at("pages/common/abc.md"));
+}
+
+#endif  // ONLINE
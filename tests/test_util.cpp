@@ -0,0 +1,121 @@
+/*
+ * Copyright 2024 Toni500git
+ * 
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ * disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "test.hpp"
+#include "update.hpp"
+#include "util.hpp"
+
+TEST(varint_round_trip)
+{
+    const std::vector<uint32_t> values = { 0, 1, 127, 128, 300, 16383, 16384, 1u << 21, 1u << 28, UINT32_MAX };
+    std::string                 data;
+    for (const uint32_t value : values)
+        write_varint(data, value);
+
+    size_t i = 0;
+    for (const uint32_t expected : values)
+    {
+        uint32_t value;
+        CHECK(read_varint(data, i, value));
+        CHECK_EQ(value, expected);
+    }
+    CHECK_EQ(i, data.size());
+
+    // truncated, and longer than 32 bits
+    uint32_t value;
+    i = 0;
+    CHECK(!read_varint("\x80\x80", i, value));
+    i = 0;
+    CHECK(!read_varint("\xff\xff\xff\xff\xff\x01", i, value));
+}
+
+// the expected hashes come from "git hash-object"
+TEST(git_blob_sha1_matches_git)
+{
+    CHECK_EQ(git_blob_sha1(""), "e69de29bb2d1d6434b8b29ae775ad8c2e48c5391");
+    CHECK_EQ(git_blob_sha1("hello\n"), "ce013625030ba8dba906f756967f9e9ca394464a");
+    CHECK_EQ(git_blob_sha1(std::string(1000, 'a')), "a50be72b20f0e3f078d252e8e56b11b4bec67509");
+
+    // around the end of the first 64 bytes block, where the padding needs one more block
+    CHECK_EQ(git_blob_sha1(std::string(47, 'x')), "719ddd7888a02660234770b651274214ff7df239");
+    CHECK_EQ(git_blob_sha1(std::string(48, 'x')), "3b3abca28de4b8ce6ea9dac5da512120ed7c5a0c");
+    CHECK_EQ(git_blob_sha1(std::string(56, 'x')), "355e203863c368f0404d7fc7ae4761122c117dd2");
+}
+
+TEST(hash_bytes_seeds)
+{
+    const std::string_view data = "en/common/tar";
+    CHECK_EQ(hash_bytes(data.data(), data.size()), hash_bytes(data.data(), data.size()));
+    CHECK(hash_bytes(data.data(), data.size(), 1) != hash_bytes(data.data(), data.size(), 2));
+}
+
+// the files used the least recently go first, until the rest fits
+TEST(evict_least_recently_used_order)
+{
+    namespace fs = std::filesystem;
+    TempDir     dir;
+    const auto& now = fs::file_time_type::clock::now();
+    for (int i = 0; i < 5; ++i)
+    {
+        const std::string& path = dir / std::to_string(i);
+        std::ofstream(path) << std::string(100, 'x');
+        // 0 is the most recently used
+        fs::last_write_time(path, now - std::chrono::minutes(i));
+    }
+
+    evict_least_recently_used(dir.path(), 1000);
+    CHECK(fs::exists(dir / "4"));
+
+    evict_least_recently_used(dir.path(), 250);
+    CHECK(fs::exists(dir / "0") && fs::exists(dir / "1"));
+    CHECK(!fs::exists(dir / "2") && !fs::exists(dir / "3") && !fs::exists(dir / "4"));
+}
+
+// the directory gets created, and a failed write leaves neither the file nor its temporary copy
+TEST(replace_file_creates_and_cleans_up)
+{
+    namespace fs = std::filesystem;
+    TempDir            dir;
+    const std::string& path = dir / "a/b/file";
+    CHECK(replace_file(path, "old"));
+    CHECK(replace_file(path, "new"));
+
+    std::string got;
+    CHECK(read_file(path, got));
+    CHECK_EQ(got, "new");
+
+    // rename() can't put a file over a directory
+    CHECK(!replace_file(dir / "a/b", "x"));
+    CHECK(fs::is_directory(dir / "a/b"));
+    CHECK(!fs::exists(temp_path(dir / "a/b")));
+    CHECK_EQ(std::distance(fs::directory_iterator(dir / "a/b"), fs::directory_iterator()), 1);
+}
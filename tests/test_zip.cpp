@@ -0,0 +1,89 @@
+/*
+ * Copyright 2024 Toni500git
+ * 
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ * disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#include <map>
+#include <random>
+#include <string>
+
+#include "test.hpp"
+#include "zip.hpp"
+#include "zip_writer.hpp"
+
+static void check_zip(const std::string& zip, const std::map<std::string, std::string>& files, std::mt19937& rng)
+{
+    std::map<std::string, std::string> got;
+    ZipStream                          stream([&](const std::string_view name, const std::string_view content) {
+        got.emplace(name, content);
+    });
+
+    // fed in chunks of any size, as they come from the network
+    for (size_t pos = 0; pos < zip.size();)
+    {
+        const size_t len = std::min<size_t>(zip.size() - pos, 1 + rng() % 64);
+        CHECK(stream.feed(std::string_view(zip).substr(pos, len)));
+        pos += len;
+    }
+
+    CHECK(stream.done());
+    CHECK(stream.error().empty());
+    CHECK(got == files);
+}
+
+TEST(zip_stream_chunks)
+{
+    std::mt19937                       rng(7);
+    std::map<std::string, std::string> files;
+    for (size_t i = 0; i < 20; ++i)
+    {
+        std::string content(rng() % 3000, ' ');
+        for (char& c : content)
+            c = "abc `{}\n"[rng() % 8];
+        files[fmt::format("tldr-main/pages/common/cmd{}.md", i)] = content;
+    }
+
+    for (size_t round = 0; round < 20; ++round)
+    {
+        check_zip(make_zip(files, false), files, rng);
+        check_zip(make_zip(files, true), files, rng);
+    }
+}
+
+TEST(zip_stream_errors)
+{
+    ZipStream garbage([](const std::string_view, const std::string_view) {});
+    CHECK(!garbage.feed("this is not a zip file"));
+    CHECK(!garbage.error().empty());
+
+    // files bigger than the limit are skipped, not kept in memory
+    std::map<std::string, std::string> files = { { "big.md", std::string(4096, 'x') }, { "small.md", "x" } };
+    std::map<std::string, std::string> got;
+    ZipStream                          stream([&](const std::string_view name, const std::string_view content) {
+        got.emplace(name, content);
+    }, 1024);
+    CHECK(stream.feed(make_zip(files, true)));
+    CHECK(stream.done());
+    CHECK_EQ(got.size(), 1u);
+    CHECK(got.count("small.md") == 1);
+}
@@ -0,0 +1,105 @@
+/*
+ * Copyright 2024 Toni500git
+ * 
+ * Redistribution and use in source and binary forms, with or without modification, are permitted provided that the
+ * following conditions are met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright notice, this list of conditions and the following
+ * disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright notice, this list of conditions and the following
+ * disclaimer in the documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Neither the name of the copyright holder nor the names of its contributors may be used to endorse or promote products
+ * derived from this software without specific prior written permission.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS “AS IS” AND ANY EXPRESS OR IMPLIED WARRANTIES,
+ * INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE
+ * DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+ * SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY,
+ * WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+#ifndef _ZIP_WRITER_HPP
+#define _ZIP_WRITER_HPP
+
+#include <zlib.h>
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+
+inline void put16(std::string& out, const uint16_t v)
+{
+    out += static_cast<char>(v & 0xff);
+    out += static_cast<char>(v >> 8);
+}
+
+inline void put32(std::string& out, const uint32_t v)
+{
+    put16(out, v & 0xffff);
+    put16(out, v >> 16);
+}
+
+inline std::string deflate_raw(const std::string_view data)
+{
+    z_stream zs{};
+    deflateInit2(&zs, Z_BEST_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+    std::string out(deflateBound(&zs, data.size()), '\0');
+    zs.next_in   = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+    zs.avail_in  = data.size();
+    zs.next_out  = reinterpret_cast<Bytef*>(out.data());
+    zs.avail_out = out.size();
+    deflate(&zs, Z_FINISH);
+    out.resize(zs.total_out);
+    deflateEnd(&zs);
+    return out;
+}
+
+/* A zip with a local file header per file, as GitHub makes them
+ * @param descriptor Whether the deflated files put their sizes in a data descriptor after the data
+ */
+inline std::string make_zip(const std::map<std::string, std::string>& files, const bool descriptor)
+{
+    std::string zip;
+    bool        deflated = false;
+    for (const auto& [name, content] : files)
+    {
+        // every other file is deflated
+        deflated                = !deflated;
+        const bool        after = deflated && descriptor;
+        const std::string data  = deflated ? deflate_raw(content) : content;
+        const uint32_t    crc   = crc32(0, reinterpret_cast<const Bytef*>(content.data()), content.size());
+
+        put32(zip, 0x04034b50);
+        put16(zip, 20);
+        put16(zip, after ? 1 << 3 : 0);
+        put16(zip, deflated ? 8 : 0);
+        put32(zip, 0);  // time and date
+        put32(zip, after ? 0 : crc);
+        put32(zip, after ? 0 : data.size());
+        put32(zip, after ? 0 : content.size());
+        put16(zip, name.size());
+        put16(zip, 0);
+        zip += name;
+        zip += data;
+        if (after)
+        {
+            put32(zip, 0x08074b50);
+            put32(zip, crc);
+            put32(zip, data.size());
+            put32(zip, content.size());
+        }
+    }
+
+    // the central directory isn't read, only its signature
+    put32(zip, 0x02014b50);
+    zip += std::string(42, '\0');
+    return zip;
+}
+
+#endif  // !_ZIP_WRITER_HPP